@@ -1,24 +1,24 @@
 #include "AsyncFF.h"
 
 namespace EGL3::Modules {
-    constexpr size_t Capacity = 32;
-
     AsyncFFModule::AsyncFFModule(ModuleList& Ctx) {
-        Futures.reserve(Capacity);
+
     }
 
-    void AsyncFFModule::Enqueue(std::future<void>&& Future) {
+    AsyncFFModule::~AsyncFFModule() {
         std::lock_guard Guard(FutureMutex);
 
-        Futures.emplace_back(std::move(Future));
+        for (auto& Future : Futures) {
+            Future.Wait();
+        }
+    }
 
-        if (Futures.size() == Futures.capacity()) {
-            std::vector<std::future<void>> OldFutures;
+    void AsyncFFModule::Track(Utils::Future<void>&& Future) {
+        std::lock_guard Guard(FutureMutex);
 
-            Futures.swap(OldFutures);
-            Futures.reserve(OldFutures.capacity());
+        // Finished jobs don't need to be waited on anymore
+        std::erase_if(Futures, [](const Utils::Future<void>& Future) { return Future.IsReady(); });
 
-            Futures.emplace_back(std::async(std::launch::async, [Olds = std::move(OldFutures)]{ ; }));
-        }
+        Futures.emplace_back(std::move(Future));
     }
 }
\ No newline at end of file
@@ -1,40 +1,44 @@
 #pragma once
 
+#include "../utils/Executor.h"
 #include "ModuleList.h"
 
-#include <future>
 #include <mutex>
 #include <vector>
 
 namespace EGL3::Modules {
-    // Inspiration from https://github.com/chris0x44/detached-task
+    // Fire and forget jobs, ran on the interactive lane of the shared executor
+    // Jobs that are still running when the module is destroyed are waited on, since they usually reference other modules
     class AsyncFFModule : public BaseModule {
         std::mutex FutureMutex;
-        std::vector<std::future<void>> Futures;
+        std::vector<Utils::Future<void>> Futures;
 
     public:
         AsyncFFModule(ModuleList& Ctx);
 
-        void Enqueue(std::future<void>&& Future);
+        ~AsyncFFModule();
 
         template<class FunctorType, class... FunctorArgs>
         void Enqueue(FunctorType&& Functor, FunctorArgs&&... Args) {
-            Enqueue(std::async(std::launch::async, [](FunctorType&& Functor, FunctorArgs&&... Args) {
-                std::invoke(std::move(Functor), std::move(Args)...);
-            }, std::move(Functor), std::move(Args)...));
+            Track(Utils::Executor::Get().Submit(Utils::TaskLane::Interactive, [Functor = std::forward<FunctorType>(Functor), ...Args = std::forward<FunctorArgs>(Args)]() mutable {
+                std::invoke(std::move(Functor), Args...);
+            }));
         }
 
         template<class FunctorType, class CallbackType, class... FunctorArgs>
         void EnqueueCallback(FunctorType&& Functor, CallbackType&& Callback, FunctorArgs&&... Args) {
-            Enqueue(std::async(std::launch::async, [](FunctorType&& Functor, CallbackType&& Callback, FunctorArgs&&... Args) {
+            Track(Utils::Executor::Get().Submit(Utils::TaskLane::Interactive, [Functor = std::forward<FunctorType>(Functor), Callback = std::forward<CallbackType>(Callback), ...Args = std::forward<FunctorArgs>(Args)]() mutable {
                 if constexpr (std::is_void_v<std::invoke_result_t<FunctorType, FunctorArgs...>>) {
-                    std::invoke(std::move(Functor), std::move(Args)...);
+                    std::invoke(std::move(Functor), Args...);
                     Callback();
                 }
                 else {
-                    Callback(std::invoke(std::move(Functor), std::move(Args)...));
+                    Callback(std::invoke(std::move(Functor), Args...));
                 }
-            }, std::move(Functor), std::move(Callback), std::move(Args)...));
+            }));
         }
+
+    private:
+        void Track(Utils::Future<void>&& Future);
     };
 }
\ No newline at end of file
@@ -40,7 +40,9 @@ namespace EGL3::Modules::Friends {
         SwitchStackPage3(Ctx.GetWidget<Gtk::Widget>("FriendsStackPage3")),
 
         MainStack(Ctx.GetWidget<Gtk::Stack>("MainStack")),
-        MainStackFriends(Ctx.GetWidget<Gtk::Widget>("AccountsContainer"))
+        MainStackFriends(Ctx.GetWidget<Gtk::Widget>("AccountsContainer")),
+
+        PresenceDispatcher(PresenceCoalesceWindow)
     {
         {
             SlotViewFriends = ViewFriendsBtn.signal_clicked().connect([this]() { OnOpenViewFriends(); });
@@ -123,6 +125,8 @@ namespace EGL3::Modules::Friends {
             UpdateTask.OnDispatch.Set([this](Web::ErrorData::Status Error) { OnUpdateDispatch(Error); });
 
             FriendUpdateDispatcher.connect([this](const std::string& AccountId, Web::Epic::Friends::FriendEventType Event) { OnFriendUpdate(AccountId, Event); });
+
+            PresenceDispatcher.connect([this](const std::string& AccountId, const Web::Epic::Friends::Presence& Presence) { OnPresenceDispatch(AccountId, Presence); });
         }
 
         {
@@ -156,10 +160,14 @@ namespace EGL3::Modules::Friends {
     }
 
     void FriendsModule::OnPresenceUpdate(const Web::Epic::Friends::Presence& Presence) {
-        if (Presence.AccountId != Auth.GetClientLauncher().GetAuthData().AccountId) {
+        PresenceDispatcher.emit(Presence.AccountId, Presence);
+    }
+
+    void FriendsModule::OnPresenceDispatch(const std::string& AccountId, const Web::Epic::Friends::Presence& Presence) {
+        if (AccountId != Auth.GetClientLauncher().GetAuthData().AccountId) {
             std::lock_guard Guard(ListMtx);
 
-            auto Friend = FriendsList.GetUser(Presence.AccountId);
+            auto Friend = FriendsList.GetUser(AccountId);
             if (Friend && Friend->GetType() == FriendType::NORMAL) {
                 Friend->Get<FriendReal>().UpdatePresence(Presence);
             }
@@ -26,6 +26,8 @@ namespace EGL3::Modules::Friends {
     private:
         void OnPresenceUpdate(const Web::Epic::Friends::Presence& Presence);
 
+        void OnPresenceDispatch(const std::string& AccountId, const Web::Epic::Friends::Presence& Presence);
+
         void OnChatReceived(const std::string& AccountId, const std::string& Message);
 
         void OnFriendEvent(const std::string& AccountId, Web::Epic::Friends::FriendEventType Event);
@@ -104,6 +106,10 @@ namespace EGL3::Modules::Friends {
 
         Utils::DataQueueDispatcher<std::string, Web::Epic::Friends::FriendEventType> FriendUpdateDispatcher;
 
+        // Presences come in bursts, only the latest one per account is applied
+        static constexpr std::chrono::milliseconds PresenceCoalesceWindow = std::chrono::milliseconds(250);
+        Utils::DataCoalescingDispatcher<std::string, Web::Epic::Friends::Presence> PresenceDispatcher;
+
         std::future<void> FriendRequestTask;
         Utils::DataDispatcher<AsyncWebRequestStatusType, std::string> FriendRequestDispatcher;
 
@@ -69,11 +69,11 @@ namespace EGL3::Modules::Friends {
 
     Storage::Models::Friend* ListModule::GetUser(const std::string& AccountId)
     {
-        auto FriendItr = std::find_if(FriendsData.begin(), FriendsData.end(), [&AccountId](const auto& Friend) {
-            return Friend->Get().GetAccountId() == AccountId;
-        });
-        if (FriendItr != FriendsData.end()) {
-            return &**FriendItr;
+        std::lock_guard Guard(FriendsDataMtx);
+
+        auto FriendItr = FriendsIndex.find(AccountId);
+        if (FriendItr != FriendsIndex.end()) {
+            return FriendItr->second;
         }
         return nullptr;
     }
@@ -97,6 +97,7 @@ namespace EGL3::Modules::Friends {
     {
         FriendList.Clear();
 
+        std::lock_guard Guard(FriendsDataMtx);
         for (auto& Friend : FriendsData) {
             FriendList.Add(*Friend);
         }
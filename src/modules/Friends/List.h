@@ -11,6 +11,8 @@
 
 #include <future>
 #include <gtkmm.h>
+#include <mutex>
+#include <unordered_map>
 
 namespace EGL3::Modules::Friends {
     class ListModule : public BaseModule {
@@ -23,7 +25,11 @@ namespace EGL3::Modules::Friends {
 
         template<class... ArgsT>
         Storage::Models::Friend& AddFriend(ArgsT&&... Args) {
-            return *FriendsData.emplace_back(std::forward<ArgsT>(Args)...);
+            std::lock_guard Guard(FriendsDataMtx);
+
+            auto& Friend = *FriendsData.emplace_back(std::forward<ArgsT>(Args)...);
+            FriendsIndex.emplace(Friend.Get().GetAccountId(), &Friend);
+            return Friend;
         }
 
         void DisplayFriend(Storage::Models::Friend& Friend);
@@ -55,6 +61,9 @@ namespace EGL3::Modules::Friends {
 
         Utils::SlotHolder SlotFilterChanged;
 
+        std::mutex FriendsDataMtx;
         std::vector<std::unique_ptr<Storage::Models::Friend>> FriendsData;
+        // Account id -> friend, presence bursts look up thousands of friends at a time
+        std::unordered_map<std::string, Storage::Models::Friend*> FriendsIndex;
     };
 }
\ No newline at end of file
@@ -1,13 +1,12 @@
 #include "Download.h"
 
 #include "../../utils/Humanize.h"
+#include "../../utils/mmio/WorkingSetGovernor.h"
 
 namespace EGL3::Modules::Game {
     using namespace Storage::Models;
 
     static constexpr double GraphScale = 1024. * 1024 * 50;
-    static constexpr std::chrono::milliseconds RefreshTime(500);
-    static constexpr double DivideRate = std::chrono::duration_cast<std::chrono::duration<double>>(RefreshTime) / std::chrono::seconds(1);
 
     namespace Colors {
         static constexpr Widgets::StateColor Unknown = 0xFFC3C2C2;
@@ -50,6 +49,8 @@ namespace EGL3::Modules::Game {
     }
 
     DownloadModule::DownloadModule(ModuleList& Ctx) :
+        NetworkRateLimit(Ctx.Get<NetworkRateLimitSetting>()),
+        WriteRateLimit(Ctx.Get<WriteRateLimitSetting>()),
         Auth(Ctx.GetModule<Login::AuthModule>()),
         GameInfo(Ctx.GetModule<GameInfoModule>()),
         Taskbar(Ctx.GetModule<TaskbarModule>()),
@@ -62,6 +63,9 @@ namespace EGL3::Modules::Game {
         OptionsFilePreview(Ctx.GetWidget<Gtk::Label>("DownloadOptionsFilePreview")),
         OptionsAutoUpdate(Ctx.GetWidget<Gtk::CheckButton>("DownloadOptionsAutoUpdate")),
         OptionsCreateShortcut(Ctx.GetWidget<Gtk::CheckButton>("DownloadOptionsCreateShortcut")),
+        OptionsKeepPrevious(Ctx.GetWidget<Gtk::CheckButton>("DownloadOptionsKeepPrevious")),
+        OptionsNetworkLimit(Ctx.GetWidget<Gtk::SpinButton>("DownloadOptionsNetworkLimit")),
+        OptionsWriteLimit(Ctx.GetWidget<Gtk::SpinButton>("DownloadOptionsWriteLimit")),
         OptionsSdMeta(Ctx.GetWidget<Gtk::TreeView>("DownloadOptionsSelector")),
         SwitchStackPageInfo(Ctx.GetWidget<Gtk::ScrolledWindow>("DownloadStackPage1")),
         InfoButtonPause(Ctx.GetWidget<Gtk::Button>("DownloadInfoPauseBtn")),
@@ -82,6 +86,9 @@ namespace EGL3::Modules::Game {
         InfoWritePeak(Ctx.GetWidget<Gtk::Label>("DownloadInfoWritePeak")),
         InfoStateGrid(Ctx.GetWidget<Gtk::DrawingArea>("DownloadInfoGraph"), ChunkStateToColor)
     {
+        NetworkLimiter.SetRate(*NetworkRateLimit);
+        WriteLimiter.SetRate(*WriteRateLimit);
+
         SlotBrowse = OptionsBrowseBtn.signal_clicked().connect([this]() { OptionsFileDialog.Show(); });
 
         OptionsFileDialog.LocationChosen.Set([this](const std::string& NewFile) {
@@ -130,7 +137,9 @@ namespace EGL3::Modules::Game {
             }
         });
 
+        // The governor trims the coldest archive pages first, well before the hard limit makes the system pick
         Utils::Mmio::MmioFile::SetWorkingSize(384ull * 1024 * 1024);
+        Utils::Mmio::WorkingSetGovernor::Get().SetBudget(256ull * 1024 * 1024);
 
         SlotLogOutPreflight = Auth.LogOutPreflight.connect([this, &Ctx]() {
             if (CurrentDownload) {
@@ -158,11 +167,12 @@ namespace EGL3::Modules::Game {
         }
     }
 
-    DownloadInfo& DownloadModule::OnDownloadClicked(Storage::Game::GameId Id, InstalledGame* GameConfig)
+    DownloadInfo& DownloadModule::OnDownloadClicked(Storage::Game::GameId Id, InstalledGame* GameConfig, std::vector<std::filesystem::path>&& SharedArchives)
     {
         ResetStats();
 
-        CurrentDownload = std::make_unique<DownloadInfo>(Id, GameConfig);
+        CurrentDownload = std::make_unique<DownloadInfo>(Id, GameConfig, &NetworkLimiter, &WriteLimiter);
+        CurrentDownload->SetSharedArchives(std::move(SharedArchives));
 
         CurrentDownload->OnStateUpdate.connect([this](DownloadInfoState NewState) {
             if (NewState == DownloadInfoState::Initializing && OptionsIsUsingEGL.has_value()) {
@@ -173,7 +183,7 @@ namespace EGL3::Modules::Game {
             }
             if (NewState == DownloadInfoState::Installing) {
                 auto& Data = CurrentDownload->GetStateData<DownloadInfo::StateInstalling>();
-                InfoStateGrid.Initialize(Data.UpdatedChunks.size());
+                InfoStateGrid.Initialize(Data.PiecesTotal);
             }
 
             StateDispatcher.emit(NewState);
@@ -206,6 +216,9 @@ namespace EGL3::Modules::Game {
         OptionsFileDialog.SetLocation(Data.ArchivePath.string());
         OptionsAutoUpdate.set_active(GetInstallFlag<InstallFlags::AutoUpdate>(Data.Flags));
         OptionsCreateShortcut.set_active(GetInstallFlag<InstallFlags::CreateShortcut>(Data.Flags));
+        OptionsKeepPrevious.set_active(GetInstallFlag<InstallFlags::KeepPreviousVersion>(Data.Flags));
+        OptionsNetworkLimit.set_value(double(GetNetworkRateLimit() / RateLimitUnit));
+        OptionsWriteLimit.set_value(double(GetWriteRateLimit() / RateLimitUnit));
         OptionsSdMeta.Initialize(InstallOpts);
         if (GetInstallFlag<InstallFlags::DefaultSelectedIds>(Data.Flags)) {
             OptionsSdMeta.SetDefaultOptions();
@@ -236,6 +249,9 @@ namespace EGL3::Modules::Game {
         auto& Data = CurrentDownload->GetStateData<DownloadInfo::StateOptions>();
         Data.Flags = SetInstallFlag<InstallFlags::AutoUpdate>(InstallFlags::SelectedIds, OptionsAutoUpdate.get_active());
         Data.Flags = SetInstallFlag<InstallFlags::CreateShortcut>(Data.Flags, OptionsCreateShortcut.get_active());
+        Data.Flags = SetInstallFlag<InstallFlags::KeepPreviousVersion>(Data.Flags, OptionsKeepPrevious.get_active());
+        SetNetworkRateLimit(uint64_t(OptionsNetworkLimit.get_value_as_int()) * RateLimitUnit);
+        SetWriteRateLimit(uint64_t(OptionsWriteLimit.get_value_as_int()) * RateLimitUnit);
         OptionsSdMeta.GetOptions(Data.SelectedIds, Data.InstallTags);
 
         CurrentDownload->BeginDownload(
@@ -274,9 +290,35 @@ namespace EGL3::Modules::Game {
         CurrentDownload->SetDownloadCancelled();
     }
 
+    void DownloadModule::SetNetworkRateLimit(uint64_t BytesPerSecond)
+    {
+        NetworkRateLimit = BytesPerSecond;
+        NetworkRateLimit.Flush();
+        NetworkLimiter.SetRate(BytesPerSecond);
+    }
+
+    uint64_t DownloadModule::GetNetworkRateLimit() const
+    {
+        return *NetworkRateLimit;
+    }
+
+    void DownloadModule::SetWriteRateLimit(uint64_t BytesPerSecond)
+    {
+        WriteRateLimit = BytesPerSecond;
+        WriteRateLimit.Flush();
+        WriteLimiter.SetRate(BytesPerSecond);
+    }
+
+    uint64_t DownloadModule::GetWriteRateLimit() const
+    {
+        return *WriteRateLimit;
+    }
+
     void DownloadModule::ResetStats()
     {
-        PiecesCompletedLast = 0;
+        NetworkEstimator.Reset();
+        ReadEstimator.Reset();
+        WriteEstimator.Reset();
         StatsBytesDownloadPeak = 0;
         StatsBytesReadPeak = 0;
         StatsBytesWritePeak = 0;
@@ -300,80 +342,50 @@ namespace EGL3::Modules::Game {
         InfoStateGrid.Initialize(0);
     }
 
-    template<>
-    std::chrono::nanoseconds DownloadModule::CalculateEndTimestamp<0>(uint32_t AmountLeft)
+    std::optional<DownloadModule::TimeLeft> DownloadModule::CalculateTimeLeft(const Storage::Models::DownloadInfoStats& Stats)
     {
-        std::vector<double> RateAvg;
-        RateAvg.reserve(StatsRateHistory.size());
-
-        for (int n = 0; n < StatsRateHistory.size(); ++n) {
-            if (n == 0) {
-                RateAvg.emplace_back(StatsRateHistory[n]);
-            }
-            else {
-                auto Weight = 1. / (n + 1);
-
-                RateAvg.emplace_back(StatsRateHistory[n] * Weight + RateAvg[n - 1] * (1 - Weight));
+        std::chrono::nanoseconds Elapsed(Stats.NanosecondCurrentTimestamp - Stats.NanosecondStartTimestamp);
+        NetworkEstimator.Update(Elapsed, Stats.BytesDownloadTotal);
+        ReadEstimator.Update(Elapsed, Stats.BytesReadTotal);
+        WriteEstimator.Update(Elapsed, Stats.BytesWriteTotal);
+
+        // Downloads, local reads and writes all run at the same time, so the one with the most time left decides
+        std::optional<TimeLeft> Ret;
+        auto AddSource = [&](const Utils::ThroughputEstimator& Estimator, uint64_t Complete, uint64_t Total) {
+            uint64_t Remaining = Total > Complete ? Total - Complete : 0;
+            if (Remaining == 0 || !Estimator.HasRate()) {
+                return;
             }
-        }
-
-        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(AmountLeft / RateAvg.back()));
-    }
-
-    template<>
-    std::chrono::nanoseconds DownloadModule::CalculateEndTimestamp<1>(uint32_t AmountLeft)
-    {
-        std::vector<double> RateAvg;
-        RateAvg.reserve(StatsRateHistory.size());
 
-        for (int n = 0; n < StatsRateHistory.size(); ++n) {
-            if (n == 0) {
-                RateAvg.emplace_back(StatsRateHistory[n]);
-            }
-            else if (n == 1) {
-                RateAvg.emplace_back((StatsRateHistory[n] + StatsRateHistory[n - 1]) / 2.);
+            TimeLeft Source{
+                .Expected = Estimator.GetTimeLeft(Remaining),
+                .Earliest = Estimator.GetTimeLeft(Remaining, 1),
+                .Latest = Estimator.GetTimeLeft(Remaining, -1)
+            };
+            if (!Ret) {
+                Ret = Source;
             }
             else {
-                auto Weight = 1. / n;
-
-                RateAvg.emplace_back(StatsRateHistory[n] * Weight + RateAvg[n - 1] * (1 - Weight));
+                Ret->Expected = std::max(Ret->Expected, Source.Expected);
+                Ret->Earliest = std::max(Ret->Earliest, Source.Earliest);
+                Ret->Latest = std::max(Ret->Latest, Source.Latest);
             }
-        }
-
-        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(AmountLeft / RateAvg.back()));
-    }
-
-    template<>
-    std::chrono::nanoseconds DownloadModule::CalculateEndTimestamp<2>(uint32_t AmountLeft)
-    {
-        std::vector<double> RateAvg;
-        RateAvg.reserve(StatsRateHistory.size());
-
-        for (int n = 0; n < StatsRateHistory.size(); ++n) {
-            if (n == 0) {
-                RateAvg.emplace_back(StatsRateHistory[n]);
-            }
-            else {
-                auto Weight = 1. / 2;
+        };
+        AddSource(NetworkEstimator, Stats.BytesDownloadTotal, Stats.DownloadTotal);
+        AddSource(ReadEstimator, Stats.BytesReadTotal, Stats.ReadTotal);
+        AddSource(WriteEstimator, Stats.BytesWriteTotal, Stats.WriteTotal);
 
-                RateAvg.emplace_back(StatsRateHistory[n] * Weight + RateAvg[n - 1] * (1 - Weight));
-            }
+        if (Ret && Ret->Expected == std::chrono::nanoseconds::max()) {
+            return std::nullopt;
         }
-
-        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(AmountLeft / RateAvg.back()));
+        return Ret;
     }
 
     void DownloadModule::OnStatsUpdate(const Storage::Models::DownloadInfoStats& Stats)
     {
-        StatsRateHistory.emplace_back(PiecesCompletedLast ? (Stats.PiecesComplete - PiecesCompletedLast) / DivideRate : 0);
-        PiecesCompletedLast = Stats.PiecesComplete;
-        while (StatsRateHistory.size() > 50) {
-            StatsRateHistory.pop_front();
-        }
-
         std::chrono::steady_clock::time_point BeginTimestamp(std::chrono::nanoseconds(Stats.NanosecondStartTimestamp));
         std::chrono::steady_clock::time_point CurrentTimestamp(std::chrono::nanoseconds(Stats.NanosecondCurrentTimestamp));
-        auto EndTimestamp = CurrentTimestamp + CalculateEndTimestamp<1>(Stats.PiecesTotal - Stats.PiecesComplete);
+        auto Left = CalculateTimeLeft(Stats);
 
         auto PiecesTotalCorrected = std::max(Stats.PiecesTotal, 1u);
         double CompletionPercent = (double)Stats.PiecesComplete / PiecesTotalCorrected;
@@ -381,6 +393,7 @@ namespace EGL3::Modules::Game {
         Taskbar.SetProgressValue(Stats.PiecesComplete, PiecesTotalCorrected);
 
         InfoState.set_text(DownloadInfoStateToString(Stats.State));
+        InfoState.set_tooltip_text(Glib::ustring::compose("Launch files installed: %1/%2", Utils::Humanize(Stats.LaunchFilesComplete), Utils::Humanize(Stats.LaunchFilesTotal)));
 
         InfoPercent.set_text(std::format("{:.0f}%", CompletionPercent * 100));
         InfoProgressBar.set_fraction(CompletionPercent);
@@ -388,8 +401,19 @@ namespace EGL3::Modules::Game {
         InfoTimeElapsed.set_text(Utils::Humanize(BeginTimestamp, CurrentTimestamp));
         InfoTimeElapsed.set_tooltip_text(Glib::ustring::format(Utils::HumanizeExact(CurrentTimestamp - BeginTimestamp)));
             
-        InfoTimeRemaining.set_text(Utils::Humanize(EndTimestamp, CurrentTimestamp));
-        InfoTimeRemaining.set_tooltip_text(Glib::ustring::format(Utils::HumanizeExact(EndTimestamp - CurrentTimestamp)));
+        if (Left) {
+            InfoTimeRemaining.set_text(Utils::Humanize(CurrentTimestamp + Left->Expected, CurrentTimestamp));
+            if (Left->Latest != std::chrono::nanoseconds::max()) {
+                InfoTimeRemaining.set_tooltip_text(Glib::ustring::compose("%1\nLikely between %2 and %3", Utils::HumanizeExact(Left->Expected), Utils::HumanizeExact(Left->Earliest), Utils::HumanizeExact(Left->Latest)));
+            }
+            else {
+                InfoTimeRemaining.set_tooltip_text(Glib::ustring::format(Utils::HumanizeExact(Left->Expected)));
+            }
+        }
+        else {
+            InfoTimeRemaining.set_text("");
+            InfoTimeRemaining.set_tooltip_text("");
+        }
 
         InfoPieces.set_text(Glib::ustring::compose("%1/%2", Utils::Humanize(Stats.PiecesComplete), Utils::Humanize(Stats.PiecesTotal)));
         InfoDownloaded.set_text(Glib::ustring::compose("%1/%2", Utils::HumanizeByteSize(Stats.BytesDownloadTotal), Utils::HumanizeByteSize(Stats.DownloadTotal)));
@@ -4,7 +4,9 @@
 #include "../../storage/models/DownloadInfo.h"
 #include "../../utils/Callback.h"
 #include "../../utils/DataDispatcher.h"
+#include "../../utils/RateLimiter.h"
 #include "../../utils/SlotHolder.h"
+#include "../../utils/ThroughputEstimator.h"
 #include "../../widgets/InstallLocationDialog.h"
 #include "../../widgets/SdTree.h"
 #include "../../widgets/StateGrid.h"
@@ -22,7 +24,8 @@ namespace EGL3::Modules::Game {
 
         ~DownloadModule();
 
-        Storage::Models::DownloadInfo& OnDownloadClicked(Storage::Game::GameId Id, Storage::Models::InstalledGame* GameConfig);
+        // SharedArchives are the user's other archives, chunks are copied from them when they have them
+        Storage::Models::DownloadInfo& OnDownloadClicked(Storage::Game::GameId Id, Storage::Models::InstalledGame* GameConfig, std::vector<std::filesystem::path>&& SharedArchives);
 
         void OnDownloadOkClicked(const Storage::Models::DownloadInfo::CreateGameConfig& CreateGameConfig);
 
@@ -32,6 +35,15 @@ namespace EGL3::Modules::Game {
 
         void OnDownloadStopClicked();
 
+        // Bytes per second across all installs, 0 for unlimited
+        void SetNetworkRateLimit(uint64_t BytesPerSecond);
+
+        uint64_t GetNetworkRateLimit() const;
+
+        void SetWriteRateLimit(uint64_t BytesPerSecond);
+
+        uint64_t GetWriteRateLimit() const;
+
     private:
         void ResetStats();
 
@@ -39,9 +51,27 @@ namespace EGL3::Modules::Game {
 
         void OnStateUpdate(Storage::Models::DownloadInfoState State);
 
-        // StatsMutex should be locked by the thread when calling
-        template<int Type>
-        std::chrono::nanoseconds CalculateEndTimestamp(uint32_t AmountLeft);
+        struct TimeLeft {
+            std::chrono::nanoseconds Expected;
+            std::chrono::nanoseconds Earliest;
+            std::chrono::nanoseconds Latest;
+        };
+
+        // Feeds the estimators, empty until there's a rate to go off of
+        std::optional<TimeLeft> CalculateTimeLeft(const Storage::Models::DownloadInfoStats& Stats);
+
+        // The options page shows the limits in mb/s
+        static constexpr uint64_t RateLimitUnit = 1024 * 1024;
+
+        using NetworkRateLimitSetting = Storage::Persistent::Setting<Utils::Crc32("DownloadNetworkRateLimit"), uint64_t>;
+        Storage::Persistent::SettingHolder<NetworkRateLimitSetting> NetworkRateLimit;
+
+        using WriteRateLimitSetting = Storage::Persistent::Setting<Utils::Crc32("DownloadWriteRateLimit"), uint64_t>;
+        Storage::Persistent::SettingHolder<WriteRateLimitSetting> WriteRateLimit;
+
+        // Shared by every install, set from the options page
+        Utils::RateLimiter NetworkLimiter;
+        Utils::RateLimiter WriteLimiter;
 
         Login::AuthModule& Auth;
         GameInfoModule& GameInfo;
@@ -56,6 +86,9 @@ namespace EGL3::Modules::Game {
         Gtk::Label& OptionsFilePreview;
         Gtk::CheckButton& OptionsAutoUpdate;
         Gtk::CheckButton& OptionsCreateShortcut;
+        Gtk::CheckButton& OptionsKeepPrevious;
+        Gtk::SpinButton& OptionsNetworkLimit;
+        Gtk::SpinButton& OptionsWriteLimit;
         Widgets::SdTree OptionsSdMeta;
         std::optional<Gtk::Label> OptionsIsUsingEGL;
 
@@ -89,8 +122,10 @@ namespace EGL3::Modules::Game {
 
         std::unique_ptr<Storage::Models::DownloadInfo> CurrentDownload;
 
-        std::deque<double> StatsRateHistory; // Used when calculating ETA
-        uint32_t PiecesCompletedLast;
+        // Used when calculating ETA
+        Utils::ThroughputEstimator NetworkEstimator;
+        Utils::ThroughputEstimator ReadEstimator;
+        Utils::ThroughputEstimator WriteEstimator;
         uint64_t StatsBytesDownloadPeak;
         uint64_t StatsBytesReadPeak;
         uint64_t StatsBytesWritePeak;
@@ -21,6 +21,7 @@ namespace EGL3::Modules::Game {
         PlayMenuBtn(Ctx.GetWidget<Gtk::MenuButton>("PlayDropdown")),
         PlayMenuVerifyOpt(Ctx.GetWidget<Gtk::MenuItem>("ExtraPlayVerifyOpt")),
         PlayMenuModifyOpt(Ctx.GetWidget<Gtk::MenuItem>("ExtraPlayModifyOpt")),
+        PlayMenuRevertOpt(Ctx.GetWidget<Gtk::MenuItem>("ExtraPlayRevertOpt")),
         PlayMenuSignOutOpt(Ctx.GetWidget<Gtk::MenuItem>("ExtraPlaySignOutOpt")),
         ShiftPressed(false),
         CurrentStateHolder(nullptr),
@@ -54,7 +55,12 @@ namespace EGL3::Modules::Game {
         });
 
         InstallStateHolder.Clicked.Set([this]() {
-            auto& Info = Download.OnDownloadClicked(PrimaryGame, GetInstall(PrimaryGame));
+            std::vector<std::filesystem::path> SharedArchives;
+            for (auto& Game : UpdateCheck.GetInstalledGames()) {
+                SharedArchives.emplace_back(Game.GetPath());
+            }
+
+            auto& Info = Download.OnDownloadClicked(PrimaryGame, GetInstall(PrimaryGame), std::move(SharedArchives));
             Info.OnStateUpdate.connect([this](Storage::Models::DownloadInfoState NewState) {
                 switch (NewState)
                 {
@@ -112,6 +118,19 @@ namespace EGL3::Modules::Game {
 
         SlotSysTrayActionClicked = SysTray.OnActionClicked.connect([this]() { PrimaryButtonClicked(); });
 
+        SlotRevertClicked = PlayMenuRevertOpt.signal_activate().connect([this]() {
+            auto Install = GetInstall(PrimaryGame);
+            if (!Install || !Install->RevertToPreviousVersion()) {
+                EGL3_LOG(LogLevel::Error, "Could not revert to the previous version");
+                return;
+            }
+
+            EGL3_LOGF(LogLevel::Info, "Reverted to {} ({})", Install->GetHeader()->GetVersionHR(), Install->GetHeader()->GetVersionNum());
+            // The version we came from is newer, so it's an update away again
+            InstallStateHolder.SetHeldState(State::Update);
+            UpdateToCurrentState();
+        });
+
         SlotShiftPress = Ctx.GetWidget<Gtk::Window>("EGL3App").signal_key_press_event().connect([this](GdkEventKey* Event) {
             ShiftPressed = Event->state & Gdk::SHIFT_MASK;
             return false;
@@ -208,6 +227,9 @@ namespace EGL3::Modules::Game {
         bool Menuable;
         GetStateData(GetCurrentState(), Label, Playable, Menuable);
         UpdateToState(Label, Playable, Menuable);
+
+        auto Install = GetInstall(PrimaryGame);
+        PlayMenuRevertOpt.set_sensitive(Install && Install->HasPreviousVersion());
     }
 
     void GameModule::UpdateToCurrentState()
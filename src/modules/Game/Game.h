@@ -86,10 +86,12 @@ namespace EGL3::Modules::Game {
         Gtk::MenuButton& PlayMenuBtn;
         Gtk::MenuItem& PlayMenuVerifyOpt;
         Gtk::MenuItem& PlayMenuModifyOpt;
+        Gtk::MenuItem& PlayMenuRevertOpt;
         Gtk::MenuItem& PlayMenuSignOutOpt;
 
         Utils::SlotHolder SlotPlayClicked;
         Utils::SlotHolder SlotSysTrayActionClicked;
+        Utils::SlotHolder SlotRevertClicked;
         Utils::SlotHolder SlotShiftPress;
         Utils::SlotHolder SlotShiftRelease;
 
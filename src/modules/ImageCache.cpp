@@ -1,52 +1,154 @@
 #include "ImageCache.h"
 
-#include "../utils/EmitRAII.h"
+#include "../utils/Config.h"
+#include "../utils/Hex.h"
+#include "../utils/SHA.h"
+#include "../utils/streams/FileStream.h"
+
+#include <algorithm>
 
 namespace EGL3::Modules {
-    ImageCacheModule::ImageCacheModule(ModuleList& Ctx) {
+    ImageCacheModule::ImageCacheModule(ModuleList& Ctx) :
+        CacheBytes(0),
+        DecodeSlots(MaxConcurrentDecodes),
+        DiskCacheDir(Utils::Config::GetFolder() / "imagecache")
+    {
+        PruneDiskCache();
+    }
+
+    ImageCacheModule::~ImageCacheModule() {
+        // Queued fetches reference this module
+        std::vector<Utils::SharedFuture<ImagePtr>> Pending;
+        {
+            std::lock_guard Guard(CacheMutex);
+            for (auto& Entry : Cache) {
+                if (!Entry.second.IsReady && Entry.second.Future.IsValid()) {
+                    Pending.emplace_back(Entry.second.Future);
+                }
+            }
+        }
 
+        for (auto& Future : Pending) {
+            Future.Wait();
+        }
     }
 
-    std::future<Glib::RefPtr<Gdk::Pixbuf>> ImageCacheModule::GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width, int Height, Glib::Dispatcher& Callback) {
-        return std::async(std::launch::async, [&, this, Width, Height](const cpr::Url& Url, const cpr::Url& FallbackUrl) {
-            Utils::EmitRAII Emitter(Callback);
-            return GetImageAsync(Url, FallbackUrl, Width, Height).get();
-        }, Url, FallbackUrl);
+    Utils::Future<Glib::RefPtr<Gdk::Pixbuf>> ImageCacheModule::GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width, int Height, Glib::Dispatcher& Callback) {
+        auto Ret = GetImageAsync(Url, FallbackUrl, Width, Height).Then([](const ImagePtr& Image) { return Image; });
+        Ret.SetOnReady([&Callback]() { Callback.emit(); });
+        return Ret;
     }
 
-    std::future<Glib::RefPtr<Gdk::Pixbuf>> ImageCacheModule::GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, Glib::Dispatcher& Callback) {
+    Utils::Future<Glib::RefPtr<Gdk::Pixbuf>> ImageCacheModule::GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, Glib::Dispatcher& Callback) {
         return GetImageAsync(Url, FallbackUrl, -1, -1, Callback);
     }
 
-    std::shared_future<Glib::RefPtr<Gdk::Pixbuf>>& ImageCacheModule::GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width, int Height) {
+    int GetByteSize(const Glib::RefPtr<Gdk::Pixbuf>& Image) {
+        return Image ? Image->get_rowstride() * Image->get_height() : 0;
+    }
+
+    Utils::SharedFuture<Glib::RefPtr<Gdk::Pixbuf>> ImageCacheModule::GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width, int Height) {
+        CacheKey Key(Url.str(), FallbackUrl.str(), Width, Height);
+        return GetOrQueue(std::move(Key), [this, Key, Url, FallbackUrl, Width, Height]() {
+            auto Ret = GetImage(Url, FallbackUrl, Width, Height);
+            // Full size requests share the pixbuf with the source entry, which already accounts for it
+            OnEntryReady(Key, Width == -1 && Height == -1 ? 0 : GetByteSize(Ret));
+            return Ret;
+        });
+    }
+
+    Utils::SharedFuture<Glib::RefPtr<Gdk::Pixbuf>> ImageCacheModule::GetSourceAsync(const std::string& Url) {
+        CacheKey Key(Url);
+        return GetOrQueue(std::move(Key), [this, Key]() {
+            auto Ret = FetchSource(Key.Url);
+            OnEntryReady(Key, GetByteSize(Ret));
+            return Ret;
+        });
+    }
+
+    template<class FuncT>
+    Utils::SharedFuture<Glib::RefPtr<Gdk::Pixbuf>> ImageCacheModule::GetOrQueue(CacheKey&& Key, FuncT&& Func) {
+        {
+            std::unique_lock Lock(CacheMutex);
+
+            while (true) {
+                auto CacheItr = Cache.find(Key);
+                if (CacheItr == Cache.end()) {
+                    break;
+                }
+
+                CacheLru.splice(CacheLru.begin(), CacheLru, CacheItr->second.LruItr);
+                if (CacheItr->second.Future.IsValid()) {
+                    return CacheItr->second.Future;
+                }
+
+                // Placeholder, another thread is submitting it right now
+                Lock.unlock();
+                std::this_thread::yield();
+                Lock.lock();
+            }
+
+            auto CacheItr = Cache.emplace(Key, CacheEntry{
+                .IsReady = false,
+                .ByteSize = 0
+            }).first;
+            CacheItr->second.LruItr = CacheLru.emplace(CacheLru.begin(), &CacheItr->first);
+        }
+
+        // Submitted without the lock, once the executor is stopping the task runs inline and takes the lock itself
+        auto Future = Utils::Executor::Get().Submit(Utils::TaskLane::Interactive, std::forward<FuncT>(Func)).Share();
+
         std::lock_guard Guard(CacheMutex);
+        auto CacheItr = Cache.find(Key);
+        if (CacheItr != Cache.end() && !CacheItr->second.Future.IsValid()) {
+            CacheItr->second.Future = Future;
+        }
+        return Future;
+    }
 
-        auto CacheItr = Cache.find(CacheKey(Url.str(), FallbackUrl.str(), Width, Height));
-        if (CacheItr != Cache.end()) {
-            return CacheItr->second;
+    void ImageCacheModule::OnEntryReady(const CacheKey& Key, size_t ByteSize) {
+        std::lock_guard Guard(CacheMutex);
+
+        auto CacheItr = Cache.find(Key);
+        if (CacheItr == Cache.end() || CacheItr->second.IsReady) {
+            return;
         }
+        CacheItr->second.IsReady = true;
+        CacheItr->second.ByteSize = ByteSize;
+        CacheBytes += ByteSize;
+
+        // Anything evicted that's still in use (held by a widget or a pending resize) stays alive through its future
+        auto LruItr = CacheLru.end();
+        while (CacheBytes > MemoryBudget && LruItr != CacheLru.begin()) {
+            --LruItr;
+            auto EvictItr = Cache.find(**LruItr);
+            if (!EvictItr->second.IsReady) {
+                continue;
+            }
 
-        return Cache.emplace(
-            CacheKey(Url.str(), FallbackUrl.str(), Width, Height),
-            std::move(std::async(std::launch::async, &ImageCacheModule::GetImage, this, Url, FallbackUrl, Width, Height))
-        ).first->second;
+            CacheBytes -= EvictItr->second.ByteSize;
+            LruItr = CacheLru.erase(LruItr);
+            Cache.erase(EvictItr);
+        }
     }
 
     Glib::RefPtr<Gdk::Pixbuf> ImageCacheModule::TryGetOrQueueImage(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width, int Height, Glib::Dispatcher& Callback)
     {
-        auto& Future = GetImageAsync(Url, FallbackUrl, Width, Height);
-        if (Future.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
-            return Future.get();
+        auto Future = GetImageAsync(Url, FallbackUrl, Width, Height);
+        if (Future.IsReady()) {
+            return Future.Get();
         }
 
         auto CacheItr = QueuedCache.find(QueuedCacheKey(Url.str(), FallbackUrl.str(), Width, Height, Callback));
         if (CacheItr == QueuedCache.end()) {
+            // Notifiers that already fired aren't needed anymore, if the image gets evicted it will be queued again
+            std::erase_if(QueuedCache, [](const auto& Item) { return Item.second.IsReady(); });
+
+            auto Notifier = Future.Then([](const ImagePtr& Image) {});
+            Notifier.SetOnReady([&Callback]() { Callback.emit(); });
             QueuedCache.emplace(
                 QueuedCacheKey(Url.str(), FallbackUrl.str(), Width, Height, Callback),
-                std::move(std::async(std::launch::async, [&Callback, &Future]() {
-                    Utils::EmitRAII Emitter(Callback);
-                    Future.get();
-                }))
+                std::move(Notifier)
             );
         }
 
@@ -58,36 +160,278 @@ namespace EGL3::Modules {
         Output->fill(0x00000000); // Fill with transparent black
     }
 
+    // Same sizing that Gdk::Pixbuf::create_from_stream_at_scale uses when preserving the aspect ratio
+    void GetScaledSize(int SourceWidth, int SourceHeight, int& Width, int& Height) {
+        if (Width <= 0 && Height <= 0) {
+            Width = SourceWidth;
+            Height = SourceHeight;
+            return;
+        }
+
+        // A missing side comes from the other one, keeping the source's aspect ratio
+        if (Width <= 0) {
+            Width = std::max((int)(0.5 + (double)Height * SourceWidth / SourceHeight), 1);
+            return;
+        }
+        if (Height <= 0) {
+            Height = std::max((int)(0.5 + (double)Width * SourceHeight / SourceWidth), 1);
+            return;
+        }
+
+        if ((double)Height * SourceWidth > (double)Width * SourceHeight) {
+            Height = std::max((int)(0.5 + (double)Width * SourceHeight / SourceWidth), 1);
+        }
+        else {
+            Width = std::max((int)(0.5 + (double)Height * SourceWidth / SourceHeight), 1);
+        }
+    }
+
     Glib::RefPtr<Gdk::Pixbuf> ImageCacheModule::GetImage(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width, int Height) {
-        Glib::RefPtr<Gdk::Pixbuf> Ret;
+        auto Source = GetSourceAsync(Url.str()).Get();
+        if (!Source && !FallbackUrl.str().empty()) {
+            Source = GetSourceAsync(FallbackUrl.str()).Get();
+        }
 
-        if (TryGetImage(Url, Ret, Width, Height)) {
+        ImagePtr Ret;
+        if (!Source) {
+            CreateEmptyImage(Ret, Width, Height);
             return Ret;
         }
 
-        if (!FallbackUrl.str().empty()){
-            if (TryGetImage(FallbackUrl, Ret, Width, Height)) {
+        if (Width == -1 && Height == -1) {
+            return Source;
+        }
+
+        int ScaledWidth = Width;
+        int ScaledHeight = Height;
+        GetScaledSize(Source->get_width(), Source->get_height(), ScaledWidth, ScaledHeight);
+        if (ScaledWidth == Source->get_width() && ScaledHeight == Source->get_height()) {
+            return Source;
+        }
+
+        DecodeSlots.acquire();
+        Ret = Source->scale_simple(ScaledWidth, ScaledHeight, Gdk::INTERP_BILINEAR);
+        DecodeSlots.release();
+        return Ret;
+    }
+
+    Glib::RefPtr<Gdk::Pixbuf> ImageCacheModule::FetchSource(const std::string& Url) {
+        if (Url.empty()) {
+            return {};
+        }
+
+        for (bool AllowCached : { true, false }) {
+            std::string Data;
+            bool FromDisk = false;
+            if (!GetImageData(Url, AllowCached, Data, FromDisk)) {
+                return {};
+            }
+
+            if (auto Ret = Decode(Data)) {
                 return Ret;
             }
+
+            if (!FromDisk) {
+                return {};
+            }
+
+            // Corrupted disk entry, drop it and go to the server
+            std::error_code Error;
+            std::filesystem::remove(GetDiskPath(Url), Error);
+        }
+
+        return {};
+    }
+
+    Glib::RefPtr<Gdk::Pixbuf> ImageCacheModule::Decode(const std::string& Data) {
+        DecodeSlots.acquire();
+
+        ImagePtr Ret;
+        try {
+            auto Stream = Gio::MemoryInputStream::create();
+            Stream->add_bytes(Glib::Bytes::create(Data.data(), Data.size()));
+            Ret = Gdk::Pixbuf::create_from_stream(Stream);
+        }
+        catch (const Glib::Error& Error) {
+            EGL3_LOGF(LogLevel::Warning, "Could not decode image ({})", (std::string)Error.what());
         }
 
-        CreateEmptyImage(Ret, Width, Height);
+        DecodeSlots.release();
         return Ret;
     }
 
-    bool ImageCacheModule::TryGetImage(const cpr::Url& Url, Glib::RefPtr<Gdk::Pixbuf>& Output, int Width, int Height) {
-        auto Response = Web::Http::Get(Url);
+    bool ImageCacheModule::GetImageData(const std::string& Url, bool AllowCached, std::string& Data, bool& FromDisk) {
+        auto Path = GetDiskPath(Url);
+
+        std::string CachedData;
+        std::string ETag;
+        std::string LastModified;
+        bool HasCached = AllowCached && ReadDiskEntry(Path, CachedData, ETag, LastModified);
+
+        if (HasCached) {
+            std::lock_guard Guard(RevalidatedMutex);
+            if (Revalidated.contains(Url)) {
+                Data = std::move(CachedData);
+                FromDisk = true;
+                return true;
+            }
+        }
+
+        cpr::Header Headers;
+        if (HasCached) {
+            if (!ETag.empty()) {
+                Headers.emplace("If-None-Match", ETag);
+            }
+            if (!LastModified.empty()) {
+                Headers.emplace("If-Modified-Since", LastModified);
+            }
+        }
+
+        auto Response = Web::Http::Get(cpr::Url(Url), Headers);
+
+        // Not modified, or the server can't be reached right now
+        // Only a real answer from the server counts as revalidating it, otherwise it's asked again next time
+        if (HasCached && (Response.status_code == 304 || Response.status_code == 0 || Response.status_code >= 500)) {
+            if (Response.status_code == 304) {
+                {
+                    std::lock_guard Guard(RevalidatedMutex);
+                    Revalidated.emplace(Url);
+                }
+                // Keeps recently used entries from being pruned
+                std::error_code Error;
+                std::filesystem::last_write_time(Path, std::filesystem::file_time_type::clock::now(), Error);
+            }
+            Data = std::move(CachedData);
+            FromDisk = true;
+            return true;
+        }
+
         if (Response.status_code != 200) {
             return false;
         }
-        auto Stream = Gio::MemoryInputStream::create();
-        Stream->add_bytes(Glib::Bytes::create(Response.text.data(), Response.text.size()));
-        if (Width == -1 && Height == -1) {
-            Output = Gdk::Pixbuf::create_from_stream(Stream);
+
+        auto GetHeader = [&Response](const char* Name) -> std::string {
+            auto Itr = Response.header.find(Name);
+            return Itr != Response.header.end() ? Itr->second : std::string();
+        };
+        WriteDiskEntry(Path, Response.text, GetHeader("ETag"), GetHeader("Last-Modified"));
+
+        {
+            std::lock_guard Guard(RevalidatedMutex);
+            Revalidated.emplace(Url);
         }
-        else {
-            Output = Gdk::Pixbuf::create_from_stream_at_scale(Stream, Width, Height, true);
+        Data = std::move(Response.text);
+        FromDisk = false;
+        return true;
+    }
+
+    void ImageCacheModule::PruneDiskCache() {
+        struct DiskEntry {
+            std::filesystem::path Path;
+            std::filesystem::file_time_type LastUsed;
+            uintmax_t Size;
+        };
+
+        std::vector<DiskEntry> Entries;
+        uintmax_t TotalSize = 0;
+
+        std::error_code Error;
+        for (auto& Entry : std::filesystem::directory_iterator(DiskCacheDir, Error)) {
+            // Leftovers from writes that were interrupted, the entry they were replacing (if any) is still intact
+            if (Entry.path().extension() == ".tmp") {
+                std::filesystem::remove(Entry.path(), Error);
+                continue;
+            }
+
+            if (Entry.path().extension() != ".img") {
+                continue;
+            }
+
+            auto Size = Entry.file_size(Error);
+            if (Error) {
+                continue;
+            }
+            auto LastUsed = Entry.last_write_time(Error);
+            if (Error) {
+                continue;
+            }
+            Entries.emplace_back(DiskEntry{ Entry.path(), LastUsed, Size });
+            TotalSize += Size;
+        }
+
+        if (TotalSize <= DiskBudget) {
+            return;
+        }
+
+        // Entries are touched whenever they're revalidated, so the oldest write is the least recently used
+        std::sort(Entries.begin(), Entries.end(), [](const DiskEntry& A, const DiskEntry& B) {
+            return A.LastUsed < B.LastUsed;
+        });
+        for (auto& Entry : Entries) {
+            if (TotalSize <= DiskBudget) {
+                break;
+            }
+            if (std::filesystem::remove(Entry.Path, Error)) {
+                TotalSize -= Entry.Size;
+            }
+        }
+    }
+
+    std::filesystem::path ImageCacheModule::GetDiskPath(const std::string& Url) const {
+        char Hash[20];
+        Utils::SHA1(Url.data(), Url.size(), Hash);
+        return (DiskCacheDir / Utils::ToHex<false>(Hash)).replace_extension("img");
+    }
+
+    // Entries are the ETag and Last-Modified headers on their own lines, followed by the encoded image
+    bool ImageCacheModule::ReadDiskEntry(const std::filesystem::path& Path, std::string& Data, std::string& ETag, std::string& LastModified) {
+        std::error_code Error;
+        if (!std::filesystem::is_regular_file(Path, Error)) {
+            return false;
+        }
+
+        Utils::Streams::FileStream Stream;
+        if (!Stream.open(Path, "rb")) {
+            return false;
+        }
+
+        std::string Contents(Stream.size(), '\0');
+        Stream.read(Contents.data(), Contents.size());
+
+        auto ETagEnd = Contents.find('\n');
+        if (ETagEnd == std::string::npos) {
+            return false;
+        }
+        auto LastModifiedEnd = Contents.find('\n', ETagEnd + 1);
+        if (LastModifiedEnd == std::string::npos) {
+            return false;
+        }
+
+        ETag = Contents.substr(0, ETagEnd);
+        LastModified = Contents.substr(ETagEnd + 1, LastModifiedEnd - ETagEnd - 1);
+        Data = Contents.substr(LastModifiedEnd + 1);
+        return !Data.empty();
+    }
+
+    void ImageCacheModule::WriteDiskEntry(const std::filesystem::path& Path, const std::string& Data, const std::string& ETag, const std::string& LastModified) {
+        // Written to the side and renamed over, so a crash never leaves a torn entry behind
+        auto TempPath = std::filesystem::path(Path).replace_extension("tmp");
+        {
+            Utils::Streams::FileStream Stream;
+            if (!Stream.open(TempPath, "wb")) {
+                return;
+            }
+            Stream.write(ETag.data(), ETag.size());
+            Stream.write("\n", 1);
+            Stream.write(LastModified.data(), LastModified.size());
+            Stream.write("\n", 1);
+            Stream.write(Data.data(), Data.size());
+        }
+
+        std::error_code Error;
+        std::filesystem::rename(TempPath, Path, Error);
+        if (Error) {
+            std::filesystem::remove(TempPath, Error);
         }
-        return (bool)Output;
     }
 }
\ No newline at end of file
@@ -1,26 +1,47 @@
 #pragma once
 
+#include "../utils/Executor.h"
 #include "../utils/HashCombine.h"
 #include "../web/Http.h"
 #include "AsyncFF.h"
 #include "ModuleList.h"
 
-#include <future>
+#include <filesystem>
 #include <gtkmm.h>
+#include <list>
+#include <semaphore>
+#include <unordered_set>
 
 namespace EGL3::Modules {
+    // Images are fetched once per url (revalidated against an on-disk copy), decoded once at full size,
+    // and every requested size is scaled down from that decode
     class ImageCacheModule : public BaseModule {
+        using ImagePtr = Glib::RefPtr<Gdk::Pixbuf>;
+
         struct CacheKey
         {
             std::string Url;
             std::string FallbackUrl;
             int RequestedWidth;
             int RequestedHeight;
+            // Full size decode of Url alone, null if it couldn't be fetched or decoded
+            bool IsSource;
 
             CacheKey(const std::string& Url, const std::string& FallbackUrl, int Width, int Height) :
                 Url(Url),
-                RequestedHeight(Width),
-                RequestedWidth(Height)
+                FallbackUrl(FallbackUrl),
+                RequestedWidth(Width),
+                RequestedHeight(Height),
+                IsSource(false)
+            {
+
+            }
+
+            CacheKey(const std::string& Url) :
+                Url(Url),
+                RequestedWidth(-1),
+                RequestedHeight(-1),
+                IsSource(true)
             {
 
             }
@@ -30,17 +51,27 @@ namespace EGL3::Modules {
                 return Url == other.Url
                     && FallbackUrl == other.FallbackUrl
                     && RequestedWidth == other.RequestedWidth
-                    && RequestedHeight == other.RequestedHeight;
+                    && RequestedHeight == other.RequestedHeight
+                    && IsSource == other.IsSource;
             }
         };
 
         struct CacheKeyHasher {
             std::size_t operator()(const CacheKey& k) const
             {
-                return Utils::HashCombine(k.Url, k.FallbackUrl, k.RequestedWidth, k.RequestedHeight);
+                return Utils::HashCombine(k.Url, k.FallbackUrl, k.RequestedWidth, k.RequestedHeight, k.IsSource);
             }
         };
 
+        struct CacheEntry {
+            // Invalid while the task is being submitted
+            Utils::SharedFuture<ImagePtr> Future;
+            // Only ready entries are evicted, pending ones have no size yet
+            bool IsReady;
+            size_t ByteSize;
+            std::list<const CacheKey*>::iterator LruItr;
+        };
+
         struct QueuedCacheKey : public CacheKey
         {
             Glib::Dispatcher& Dispatcher;
@@ -49,7 +80,7 @@ namespace EGL3::Modules {
                 CacheKey(Url, FallbackUrl, Width, Height),
                 Dispatcher(Dispatcher)
             {
-                
+
             }
 
             bool operator==(const QueuedCacheKey& other) const
@@ -69,24 +100,69 @@ namespace EGL3::Modules {
             }
         };
 
+        // Decoded bytes kept in memory, images that are still referenced elsewhere stay alive past this
+        static constexpr size_t MemoryBudget = 64 * 1024 * 1024;
+        static constexpr std::ptrdiff_t MaxConcurrentDecodes = 4;
+        // Encoded bytes kept on disk, pruned down to this on startup
+        static constexpr uintmax_t DiskBudget = 256 * 1024 * 1024;
+
         std::mutex CacheMutex;
-        std::unordered_map<CacheKey, std::shared_future<Glib::RefPtr<Gdk::Pixbuf>>, CacheKeyHasher> Cache;
-        std::unordered_map<QueuedCacheKey, std::future<void>, QueuedCacheKeyHasher> QueuedCache;
+        std::unordered_map<CacheKey, CacheEntry, CacheKeyHasher> Cache;
+        // Most recently used first
+        std::list<const CacheKey*> CacheLru;
+        size_t CacheBytes;
+
+        // Only used from the gui thread
+        std::unordered_map<QueuedCacheKey, Utils::Future<void>, QueuedCacheKeyHasher> QueuedCache;
+
+        std::counting_semaphore<MaxConcurrentDecodes> DecodeSlots;
+
+        // Urls checked against the server this session, their disk copies are trusted from then on
+        std::mutex RevalidatedMutex;
+        std::unordered_set<std::string> Revalidated;
+
+        std::filesystem::path DiskCacheDir;
 
     public:
         ImageCacheModule(ModuleList& Ctx);
 
-        std::future<Glib::RefPtr<Gdk::Pixbuf>> GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width, int Height, Glib::Dispatcher& Callback);
+        ~ImageCacheModule();
+
+        // Callback is emitted once the image is ready, unless the returned future is destroyed before then
+        Utils::Future<ImagePtr> GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width, int Height, Glib::Dispatcher& Callback);
 
-        std::future<Glib::RefPtr<Gdk::Pixbuf>> GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, Glib::Dispatcher& Callback);
+        Utils::Future<ImagePtr> GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, Glib::Dispatcher& Callback);
 
-        std::shared_future<Glib::RefPtr<Gdk::Pixbuf>>& GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width = -1, int Height = -1);
+        Utils::SharedFuture<ImagePtr> GetImageAsync(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width = -1, int Height = -1);
 
         // Run only on gui thread, that's what this is primarily for
-        Glib::RefPtr<Gdk::Pixbuf> TryGetOrQueueImage(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width, int Height, Glib::Dispatcher& Callback);
+        ImagePtr TryGetOrQueueImage(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width, int Height, Glib::Dispatcher& Callback);
+
+        ImagePtr GetImage(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width = -1, int Height = -1);
+
+    private:
+        Utils::SharedFuture<ImagePtr> GetSourceAsync(const std::string& Url);
+
+        template<class FuncT>
+        Utils::SharedFuture<ImagePtr> GetOrQueue(CacheKey&& Key, FuncT&& Func);
+
+        // Records the size of a finished entry and evicts the least recently used ones past the budget
+        void OnEntryReady(const CacheKey& Key, size_t ByteSize);
+
+        ImagePtr FetchSource(const std::string& Url);
+
+        ImagePtr Decode(const std::string& Data);
+
+        // Gets the encoded image from the disk cache or the server, FromDisk is set if it came from the disk cache
+        bool GetImageData(const std::string& Url, bool AllowCached, std::string& Data, bool& FromDisk);
+
+        // Removes interrupted writes and the least recently used entries past the budget
+        void PruneDiskCache();
+
+        std::filesystem::path GetDiskPath(const std::string& Url) const;
 
-        Glib::RefPtr<Gdk::Pixbuf> GetImage(const cpr::Url& Url, const cpr::Url& FallbackUrl, int Width = -1, int Height = -1);
+        static bool ReadDiskEntry(const std::filesystem::path& Path, std::string& Data, std::string& ETag, std::string& LastModified);
 
-        bool TryGetImage(const cpr::Url& Url, Glib::RefPtr<Gdk::Pixbuf>& Output, int Width = -1, int Height = -1);
+        static void WriteDiskEntry(const std::filesystem::path& Path, const std::string& Data, const std::string& ETag, const std::string& LastModified);
     };
 }
\ No newline at end of file
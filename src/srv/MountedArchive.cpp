@@ -1,6 +1,8 @@
 #include "MountedArchive.h"
 
+#include "../storage/game/LaunchFiles.h"
 #include "../utils/Align.h"
+#include "../utils/Log.h"
 #include "../utils/Random.h"
 
 namespace EGL3::Service {
@@ -9,7 +11,8 @@ namespace EGL3::Service {
     MountedArchive::MountedArchive(const std::filesystem::path& Path, Game::Archive&& Archive) :
         Archive(std::move(Archive)),
         ArchiveLists(this->Archive),
-        LUT(ArchiveLists),
+        AccessLog(ArchiveLists.Files.size()),
+        LUT(ArchiveLists, AccessLog),
         Disk(GetMountedFiles(), Utils::Random(), HandleCluster),
         DriveLetter(0)
     {
@@ -22,6 +25,17 @@ namespace EGL3::Service {
 
     MountedArchive::~MountedArchive()
     {
+        auto Order = AccessLog.GetOrder();
+        if (Order.empty()) {
+            return;
+        }
+
+        std::vector<std::string> Filenames;
+        Filenames.reserve(Order.size());
+        for (auto FileIdx : Order) {
+            Filenames.emplace_back(ArchiveLists.Files[FileIdx].Filename);
+        }
+        EGL3_ENSURE(Game::LaunchFiles(std::move(Filenames)).Save(Archive.GetPath()), LogLevel::Warning, "Could not save launch files");
     }
 
     char MountedArchive::GetDriveLetter() const
@@ -48,7 +62,32 @@ namespace EGL3::Service {
         return Stats{};
     }
 
-    MountedArchive::SectionLUT::SectionLUT(const Lists& ArchiveLists)
+    MountedArchive::FileAccessLog::FileAccessLog(size_t FileCount) :
+        Seen(std::make_unique<std::atomic<bool>[]>(FileCount))
+    {
+        Order.reserve(Game::LaunchFiles::MaxFileCount);
+    }
+
+    void MountedArchive::FileAccessLog::OnRead(uint32_t FileIdx) noexcept
+    {
+        // Every cluster read goes through here, only the first read of a file takes the lock
+        if (Seen[FileIdx].load(std::memory_order::relaxed) || Seen[FileIdx].exchange(true)) {
+            return;
+        }
+
+        std::lock_guard Guard(Mutex);
+        if (Order.size() < Game::LaunchFiles::MaxFileCount) {
+            Order.emplace_back(FileIdx);
+        }
+    }
+
+    std::vector<uint32_t> MountedArchive::FileAccessLog::GetOrder() const
+    {
+        std::lock_guard Guard(Mutex);
+        return Order;
+    }
+
+    MountedArchive::SectionLUT::SectionLUT(const Lists& ArchiveLists, FileAccessLog& AccessLog)
     {
         Contexts.reserve(ArchiveLists.Files.size());
 
@@ -85,13 +124,15 @@ namespace EGL3::Service {
                 ++PartIdx;
             }
 
-            Contexts.emplace_back(std::move(LUT), std::move(Parts));
+            Contexts.emplace_back(std::move(LUT), std::move(Parts), uint32_t(Contexts.size()), AccessLog);
         }
     }
 
-    MountedArchive::SectionContext::SectionContext(std::vector<std::pair<uint32_t, uint32_t>>&& LUT, std::vector<std::pair<Storage::Game::ArchiveListIteratorReadonly<Storage::Game::RunlistId::ChunkData>, uint32_t>>&& Parts) :
+    MountedArchive::SectionContext::SectionContext(std::vector<std::pair<uint32_t, uint32_t>>&& LUT, std::vector<std::pair<Storage::Game::ArchiveListIteratorReadonly<Storage::Game::RunlistId::ChunkData>, uint32_t>>&& Parts, uint32_t FileIdx, FileAccessLog& AccessLog) :
         LUT(std::move(LUT)),
-        Parts(std::move(Parts))
+        Parts(std::move(Parts)),
+        FileIdx(FileIdx),
+        AccessLog(&AccessLog)
     {
 
     }
@@ -119,6 +160,8 @@ namespace EGL3::Service {
         // Context for the specific file
         auto& Ctx = *(MountedArchive::SectionContext*)CtxPtr;
 
+        Ctx.AccessLog->OnRead(Ctx.FileIdx);
+
         // Get the right part to begin reading from
         auto PartItr = Ctx.Parts.begin() + Ctx.LUT[LCN].first;
         uint32_t PartOffset = Ctx.LUT[LCN].second;
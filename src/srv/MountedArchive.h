@@ -4,6 +4,9 @@
 #include "DriveCounter.h"
 #include "MountedDisk.h"
 
+#include <atomic>
+#include <mutex>
+
 namespace EGL3::Service {
     class MountedArchive {
     public:
@@ -36,20 +39,37 @@ namespace EGL3::Service {
             }
         };
 
+        // Records the order files are first read in after mounting, saved as the archive's launch files
+        class FileAccessLog {
+        public:
+            FileAccessLog(size_t FileCount);
+
+            void OnRead(uint32_t FileIdx) noexcept;
+
+            std::vector<uint32_t> GetOrder() const;
+
+        private:
+            std::unique_ptr<std::atomic<bool>[]> Seen;
+            mutable std::mutex Mutex;
+            std::vector<uint32_t> Order;
+        };
+
         struct SectionContext {
             // Idx is LCN, stores a pair of (PartIdx, Offset)
             const std::vector<std::pair<uint32_t, uint32_t>> LUT;
             // One for every corresponding ChunkPart, stored as (Itr [with its offset already added], Size)
             const std::vector<std::pair<Storage::Game::ArchiveListIteratorReadonly<Storage::Game::RunlistId::ChunkData>, uint32_t>> Parts;
+            const uint32_t FileIdx;
+            FileAccessLog* const AccessLog;
 
-            SectionContext(std::vector<std::pair<uint32_t, uint32_t>>&& LUT, std::vector<std::pair<Storage::Game::ArchiveListIteratorReadonly<Storage::Game::RunlistId::ChunkData>, uint32_t>>&& Parts);
+            SectionContext(std::vector<std::pair<uint32_t, uint32_t>>&& LUT, std::vector<std::pair<Storage::Game::ArchiveListIteratorReadonly<Storage::Game::RunlistId::ChunkData>, uint32_t>>&& Parts, uint32_t FileIdx, FileAccessLog& AccessLog);
         };
 
         struct SectionLUT {
             // One per file
             std::vector<SectionContext> Contexts;
 
-            SectionLUT(const Lists& ArchiveLists);
+            SectionLUT(const Lists& ArchiveLists, FileAccessLog& AccessLog);
         };
 
         std::vector<MountedFile> GetMountedFiles();
@@ -58,6 +78,7 @@ namespace EGL3::Service {
 
         Storage::Game::Archive Archive;
         const Lists ArchiveLists;
+        FileAccessLog AccessLog;
         const SectionLUT LUT;
         MountedDisk Disk;
         mutable DriveCounter Counter;
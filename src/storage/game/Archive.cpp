@@ -182,6 +182,12 @@ namespace EGL3::Storage::Game {
         // Number of more sectors that the run needs to have to reach the target size
         uint64_t MoreSectorsNeeded = RequiredSectors - AllocatedSectors;
 
+        // Chunk data is most of the archive, growing it in large page sized steps keeps its runs few and long
+        bool IsChunkData = Runlist->GetId() == RunlistId::ChunkData;
+        if (IsChunkData) {
+            MoreSectorsNeeded = Utils::Align<ChunkDataGranularity / Header::GetSectorSize()>(MoreSectorsNeeded);
+        }
+
         // We will need to modify the index/runlist past this point
         if (RunIndex->GetRunCount() > 0) {
             if (RunIndex->GetRuns()[RunIndex->GetRunCount() - 1].Id == Runlist->GetId()) {
@@ -194,6 +200,15 @@ namespace EGL3::Storage::Game {
             }
         }
 
+        // New chunk data runs start on a large page boundary, whatever run is before it gets the sectors in between
+        if (IsChunkData && RunIndex->GetRunCount() > 0) {
+            uint32_t NextSector = RunIndex->GetNextAvailableSector();
+            uint32_t Padding = Utils::Align<ChunkDataGranularity / Header::GetSectorSize()>(NextSector) - NextSector;
+            if (Padding) {
+                PadLastRun(Padding);
+            }
+        }
+
         // We need to add a new run to the index and to the runlist
         EGL3_VERIFY(Runlist->EmplaceRun(RunIndex->GetNextAvailableSector(), MoreSectorsNeeded), "Runlist ran out of available runs");
         EGL3_VERIFY(RunIndex->EmplaceRun(MoreSectorsNeeded, Runlist->GetId()), "Run index ran out of available runs");
@@ -201,6 +216,36 @@ namespace EGL3::Storage::Game {
         Backend->EnsureSize(RunIndex->GetNextAvailableSector() * Header::GetSectorSize());
     }
 
+    void Archive::PadLastRun(uint32_t SectorCount)
+    {
+        switch (RunIndex->GetRuns()[RunIndex->GetRunCount() - 1].Id)
+        {
+        case RunlistId::File:
+            RunlistFile->ExtendLastRun(SectorCount);
+            break;
+        case RunlistId::ChunkPart:
+            RunlistChunkPart->ExtendLastRun(SectorCount);
+            break;
+        case RunlistId::ChunkInfo:
+            RunlistChunkInfo->ExtendLastRun(SectorCount);
+            break;
+        case RunlistId::ChunkData:
+            RunlistChunkData->ExtendLastRun(SectorCount);
+            break;
+        default:
+            EGL3_VERIFY(false, "Last run has an unknown runlist id");
+        }
+        RunIndex->ExtendLastRun(SectorCount);
+    }
+
+    void Archive::WriteBack(const std::vector<Utils::Mmio::FlushCoalescer::Range>& Ranges)
+    {
+        for (auto& Range : Ranges) {
+            Backend->WriteBack(Range.Position, Range.Size);
+            Backend->Flush(Range.Position, Range.Size);
+        }
+    }
+
     template<uint32_t MaxRunCount>
     void Archive::FlushRunlist(const Runlist<MaxRunCount>& Runlist, size_t Position, size_t Size)
     {
@@ -211,11 +256,11 @@ namespace EGL3::Storage::Game {
             for (auto CurrentRunItr = Runlist.GetRuns().begin() + RunStartIndex; CurrentRunItr != Runlist.GetRuns().end(); ++CurrentRunItr) {
                 size_t Offset = CurrentRunItr->SectorOffset * Header::GetSectorSize() + RunByteOffset;
                 if ((Size - BytesFlushed) > CurrentRunItr->SectorCount * Header::GetSectorSize() - RunByteOffset) { // flush the entire buffer
-                    Backend->Flush(Offset, CurrentRunItr->SectorCount * Header::GetSectorSize() - RunByteOffset);
+                    WriteBack(DirtyRanges.Add(Offset, CurrentRunItr->SectorCount * Header::GetSectorSize() - RunByteOffset));
                     BytesFlushed += CurrentRunItr->SectorCount * Header::GetSectorSize() - RunByteOffset;
                 }
                 else { // flush the rest
-                    Backend->Flush(Offset, Size - BytesFlushed);
+                    WriteBack(DirtyRanges.Add(Offset, Size - BytesFlushed));
                     BytesFlushed += Size - BytesFlushed;
                     break;
                 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../../utils/mmio/FlushCoalescer.h"
 #include "../../utils/mmio/MmioFile.h"
 #include "ArchiveRef.h"
 
@@ -51,10 +52,17 @@ namespace EGL3::Storage::Game {
             return Backend->Get();
         }
 
+        // Makes everything written so far durable, including ranges that are still waiting to be written back
         void Flush() {
+            DirtyRanges.TakeAll();
             Backend->Flush();
         }
 
+        // Bytes written that are still waiting to be written back
+        size_t GetPendingWriteBackBytes() const {
+            return DirtyRanges.GetDirtyBytes();
+        }
+
         const ArchiveRefConst<Header>& GetHeader() const {
             return Header;
         }
@@ -134,12 +142,19 @@ namespace EGL3::Storage::Game {
         template<uint32_t MaxRunCount>
         void Reserve(ArchiveRef<Runlist<MaxRunCount>>& Runlist, uint64_t NewAllocatedSize);
 
+        // Queues the range to be written back, the queued ranges are merged and written out together
+        // once enough of them pile up
         template<uint32_t MaxRunCount>
         void FlushRunlist(const Runlist<MaxRunCount>& Runlist, size_t Position, size_t Size);
 
     private:
         void Construct();
 
+        // Gives more sectors to the last run in the index, must hold ResizeMutex
+        void PadLastRun(uint32_t SectorCount);
+
+        void WriteBack(const std::vector<Utils::Mmio::FlushCoalescer::Range>& Ranges);
+
         // at offset 0, size 256
         ArchiveRef<Header> Header;
 
@@ -168,6 +183,11 @@ namespace EGL3::Storage::Game {
         bool Valid;
 
         std::mutex ResizeMutex;
+
+        // Chunk data runs are allocated in steps of this many bytes, the size of a large page
+        static constexpr uint64_t ChunkDataGranularity = 1ull << 21;
+
+        Utils::Mmio::FlushCoalescer DirtyRanges;
     };
 
     template size_t Archive::ReadRunlist<1789>(const Runlist<1789>&, size_t, char*, size_t) const;
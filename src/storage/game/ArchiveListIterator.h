@@ -93,14 +93,19 @@ namespace EGL3::Storage::Game {
         void FastWrite(const T* Source, size_t Count) const noexcept {
             Count *= sizeof(typename ArchiveListIterator<Id>::T);
 
-            auto Base = this->Runlist.GetBase();
+            auto& File = this->Runlist.GetFile();
 
             size_t RunIdx = this->CurrentRunIdx;
             size_t RunOff = this->CurrentRunOffset;
             while (Count) {
                 size_t WriteAmt = std::min(this->Runlist->GetRunSize(RunIdx) - RunOff, Count);
+                size_t Position = this->Runlist->GetPosition(RunIdx, 0) + RunOff;
 
-                memcpy(Base + this->Runlist->GetPosition(RunIdx, 0) + RunOff, Source, WriteAmt);
+                // Going through the file handle skips faulting the pages into the working set
+                // The view is only written to if the file couldn't be
+                if (!File.Write(Position, Source, WriteAmt)) {
+                    memcpy(File.Get() + Position, Source, WriteAmt);
+                }
 
                 RunOff = 0;
                 RunIdx++;
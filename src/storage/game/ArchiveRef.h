@@ -91,6 +91,10 @@ namespace EGL3::Storage::Game {
             return Base::Archive->Get();
         }
 
+        Utils::Mmio::MmioFile& GetFile() const noexcept {
+            return *Base::Archive;
+        }
+
         std::strong_ordering operator<=>(const ArchiveRef& that) const noexcept {
             if (auto cmp = Base::Offset <=> that.Offset; cmp != 0)
                 return cmp;
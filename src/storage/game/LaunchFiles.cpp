@@ -0,0 +1,54 @@
+#include "LaunchFiles.h"
+
+#include <fstream>
+
+namespace EGL3::Storage::Game {
+    LaunchFiles::LaunchFiles(std::vector<std::string>&& Files) :
+        Files(std::move(Files))
+    {
+        if (this->Files.size() > MaxFileCount) {
+            this->Files.resize(MaxFileCount);
+        }
+    }
+
+    LaunchFiles LaunchFiles::Load(const std::filesystem::path& ArchivePath)
+    {
+        std::ifstream Stream(GetPath(ArchivePath));
+        if (!Stream) {
+            return {};
+        }
+
+        std::vector<std::string> Files;
+        std::string Line;
+        while (Files.size() < MaxFileCount && std::getline(Stream, Line)) {
+            if (!Line.empty()) {
+                Files.emplace_back(std::move(Line));
+            }
+        }
+        return LaunchFiles(std::move(Files));
+    }
+
+    bool LaunchFiles::Save(const std::filesystem::path& ArchivePath) const
+    {
+        std::ofstream Stream(GetPath(ArchivePath), std::ios::trunc);
+        if (!Stream) {
+            return false;
+        }
+
+        for (auto& File : Files) {
+            Stream << File << '\n';
+        }
+        return (bool)Stream;
+    }
+
+    const std::vector<std::string>& LaunchFiles::GetFiles() const
+    {
+        return Files;
+    }
+
+    std::filesystem::path LaunchFiles::GetPath(const std::filesystem::path& ArchivePath)
+    {
+        auto Path = ArchivePath;
+        return Path += ".launch";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace EGL3::Storage::Game {
+    // Files the game opened first, in order, the last time it was played from an archive
+    // The service writes them next to the archive when it's unmounted, installs use them to decide what to install first
+    class LaunchFiles {
+    public:
+        static constexpr size_t MaxFileCount = 256;
+
+        LaunchFiles() = default;
+
+        LaunchFiles(std::vector<std::string>&& Files);
+
+        static LaunchFiles Load(const std::filesystem::path& ArchivePath);
+
+        bool Save(const std::filesystem::path& ArchivePath) const;
+
+        const std::vector<std::string>& GetFiles() const;
+
+    private:
+        static std::filesystem::path GetPath(const std::filesystem::path& ArchivePath);
+
+        std::vector<std::string> Files;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "ArchiveChunkProvider.h"
+
+#include "../../utils/formatters/Path.h"
+#include "../../utils/Log.h"
+#include "../../utils/SHA.h"
+#include "../game/ArchiveList.h"
+
+#include <algorithm>
+
+namespace EGL3::Storage::Models {
+    ArchiveChunkProvider::ArchiveChunkProvider(const std::vector<std::filesystem::path>& ArchivePaths)
+    {
+        for (auto& Path : ArchivePaths) {
+            std::error_code Code;
+            if (!std::filesystem::is_regular_file(Path, Code)) {
+                continue;
+            }
+
+            auto ArchivePtr = std::make_unique<Game::Archive>(Path, Game::ArchiveMode::Read);
+            if (!ArchivePtr->IsValid()) {
+                continue;
+            }
+
+            const Game::ArchiveList<Game::RunlistId::ChunkInfo> ChunkInfos(*ArchivePtr);
+            const Game::ArchiveList<Game::RunlistId::ChunkData> ChunkDatas(*ArchivePtr);
+
+            size_t OldSize = LUT.size();
+            uint32_t ChunkIdx = 0;
+            for (auto& Info : ChunkInfos) {
+                // Unused slots and chunks that would run past the data are left out
+                if (Info.CompressedSize == Info.UncompressedSize && Info.UncompressedSize &&
+                    (uint64_t)Info.DataSector * Game::Header::GetSectorSize() + Info.UncompressedSize <= ChunkDatas.size()) {
+                    auto& Entry = LUT.emplace_back(ChunkEntry{ .ArchiveIdx = uint32_t(Archives.size()), .ChunkIdx = ChunkIdx });
+                    memcpy(Entry.SHA, Info.SHA, sizeof(Entry.SHA));
+                }
+                ++ChunkIdx;
+            }
+
+            if (LUT.size() != OldSize) {
+                EGL3_LOGF(LogLevel::Info, "Found {} chunks to share in {}", LUT.size() - OldSize, Path);
+                Archives.emplace_back(std::move(ArchivePtr));
+            }
+        }
+
+        std::sort(LUT.begin(), LUT.end(), [](const ChunkEntry& A, const ChunkEntry& B) {
+            return memcmp(A.SHA, B.SHA, sizeof(A.SHA)) < 0;
+        });
+    }
+
+    bool ArchiveChunkProvider::IsValid() const
+    {
+        return !LUT.empty();
+    }
+
+    size_t ArchiveChunkProvider::GetChunkCount() const
+    {
+        return LUT.size();
+    }
+
+    bool ArchiveChunkProvider::IsChunkAvailable(const Web::Epic::BPS::ChunkInfo& Chunk) const
+    {
+        return FindChunk(Chunk);
+    }
+
+    bool ArchiveChunkProvider::ReadChunk(const Web::Epic::BPS::ChunkInfo& Chunk, char* Dst) const
+    {
+        auto Entry = FindChunk(Chunk);
+        if (!Entry) {
+            return false;
+        }
+
+        auto& ArchivePtr = Archives[Entry->ArchiveIdx];
+        const Game::ArchiveList<Game::RunlistId::ChunkInfo> ChunkInfos(*ArchivePtr);
+        const Game::ArchiveList<Game::RunlistId::ChunkData> ChunkDatas(*ArchivePtr);
+
+        auto& Info = ChunkInfos[Entry->ChunkIdx];
+        if (Info.UncompressedSize != Chunk.WindowSize) {
+            return false;
+        }
+
+        (ChunkDatas.begin() + (uint64_t)Info.DataSector * Game::Header::GetSectorSize()).FastRead(Dst, Chunk.WindowSize);
+
+        // The other archive could be in the middle of an update, the data has to be checked
+        return Utils::SHA1Verify(Dst, Chunk.WindowSize, Chunk.SHAHash);
+    }
+
+    const ArchiveChunkProvider::ChunkEntry* ArchiveChunkProvider::FindChunk(const Web::Epic::BPS::ChunkInfo& Chunk) const
+    {
+        auto Itr = std::lower_bound(LUT.begin(), LUT.end(), Chunk.SHAHash, [](const ChunkEntry& Entry, const char* SHA) {
+            return memcmp(Entry.SHA, SHA, sizeof(Entry.SHA)) < 0;
+        });
+        if (Itr == LUT.end() || memcmp(Itr->SHA, Chunk.SHAHash, sizeof(Itr->SHA)) != 0) {
+            return nullptr;
+        }
+        return &*Itr;
+    }
+}
\ No newline at end of file
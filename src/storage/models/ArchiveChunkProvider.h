@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../../web/epic/bps/Manifest.h"
+#include "../game/Archive.h"
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace EGL3::Storage::Models {
+    // Finds chunks in the user's other archives (other games or versions) by their SHA, so data that's
+    // already on disk is copied from there instead of being downloaded again
+    // Only uncompressed chunks are indexed, they can be copied as is
+    class ArchiveChunkProvider {
+    public:
+        ArchiveChunkProvider() = default;
+
+        // Archives that can't be opened for reading (like one that's being written to) are skipped
+        ArchiveChunkProvider(const std::vector<std::filesystem::path>& ArchivePaths);
+
+        bool IsValid() const;
+
+        size_t GetChunkCount() const;
+
+        bool IsChunkAvailable(const Web::Epic::BPS::ChunkInfo& Chunk) const;
+
+        // Dst must fit the chunk's WindowSize
+        // Returns false if the chunk isn't available or the copy doesn't match its SHA
+        bool ReadChunk(const Web::Epic::BPS::ChunkInfo& Chunk, char* Dst) const;
+
+    private:
+        struct ChunkEntry {
+            char SHA[20];
+            uint32_t ArchiveIdx;
+            uint32_t ChunkIdx;
+        };
+
+        const ChunkEntry* FindChunk(const Web::Epic::BPS::ChunkInfo& Chunk) const;
+
+        // Archives aren't movable while lists point into them
+        std::vector<std::unique_ptr<Game::Archive>> Archives;
+        // Sorted by SHA
+        std::vector<ChunkEntry> LUT;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "ArchiveSnapshot.h"
+
+#include "../../utils/formatters/Path.h"
+#include "../../utils/streams/FileStream.h"
+#include "../../utils/Log.h"
+#include "../game/ArchiveList.h"
+
+#include <algorithm>
+
+namespace EGL3::Storage::Models {
+    struct SnapshotHeader {
+        uint32_t Magic;
+        Game::Header Header;
+        Game::ManifestData ManifestData;
+        uint64_t ChunkInfoCount;
+        uint64_t FileCount;
+        uint64_t ChunkPartCount;
+    };
+
+    // Opens the snapshot and checks its header, the stream is left right after it
+    static bool OpenSnapshot(const std::filesystem::path& Path, Utils::Streams::FileStream& Stream, SnapshotHeader& Header)
+    {
+        if (!EGL3_ENSURE(Stream.open(Path, "rb"), LogLevel::Error, "Could not open archive snapshot for reading")) {
+            return false;
+        }
+
+        if (!EGL3_ENSURE(Stream.size() >= sizeof(Header), LogLevel::Error, "Archive snapshot is too small")) {
+            return false;
+        }
+        Stream.read((char*)&Header, sizeof(Header));
+
+        if (!EGL3_ENSURE(Header.Magic == ArchiveSnapshot::ExpectedMagic && Header.Header.HasValidMagic(), LogLevel::Error, "Archive snapshot has invalid magic")) {
+            return false;
+        }
+        if (!EGL3_ENSURE(Stream.size() == sizeof(Header) + Header.FileCount * sizeof(Game::File) + Header.ChunkPartCount * sizeof(Game::ChunkPart), LogLevel::Error, "Archive snapshot has an invalid size")) {
+            return false;
+        }
+        return true;
+    }
+
+    std::filesystem::path ArchiveSnapshot::GetPath(const std::filesystem::path& ArchivePath)
+    {
+        auto Path = ArchivePath;
+        return Path += ".prev";
+    }
+
+    bool ArchiveSnapshot::Exists(const std::filesystem::path& ArchivePath)
+    {
+        std::error_code Code;
+        return std::filesystem::is_regular_file(GetPath(ArchivePath), Code);
+    }
+
+    bool ArchiveSnapshot::Save(Game::Archive& Archive)
+    {
+        if (!EGL3_ENSURE(!Archive.GetHeader()->GetUpdateInfo().IsUpdating, LogLevel::Warning, "Can't snapshot an archive that's being updated")) {
+            return false;
+        }
+
+        const Game::ArchiveList<Game::RunlistId::File> Files(Archive);
+        const Game::ArchiveList<Game::RunlistId::ChunkPart> ChunkParts(Archive);
+        const Game::ArchiveList<Game::RunlistId::ChunkInfo> ChunkInfos(Archive);
+
+        SnapshotHeader Header{
+            .Magic = ExpectedMagic,
+            .Header = *Archive.GetHeader(),
+            .ManifestData = *Archive.GetManifestData(),
+            .ChunkInfoCount = ChunkInfos.size(),
+            .FileCount = Files.size(),
+            .ChunkPartCount = ChunkParts.size()
+        };
+
+        Utils::Streams::FileStream Stream;
+        if (!EGL3_ENSURE(Stream.open(GetPath(Archive.GetPath()), "wb"), LogLevel::Error, "Could not open archive snapshot for writing")) {
+            return false;
+        }
+
+        Stream.write((const char*)&Header, sizeof(Header));
+
+        auto File = std::make_unique<Game::File[]>(Files.size());
+        Files.begin().FastRead(File.get(), Files.size());
+        Stream.write((const char*)File.get(), Files.size() * sizeof(Game::File));
+
+        auto ChunkPart = std::make_unique<Game::ChunkPart[]>(ChunkParts.size());
+        ChunkParts.begin().FastRead(ChunkPart.get(), ChunkParts.size());
+        Stream.write((const char*)ChunkPart.get(), ChunkParts.size() * sizeof(Game::ChunkPart));
+
+        EGL3_LOGF(LogLevel::Info, "Saved {} files of {} {} to {}", Files.size(), Header.Header.GetGame(), Header.Header.GetVersionHR(), GetPath(Archive.GetPath()));
+        return true;
+    }
+
+    bool ArchiveSnapshot::Revert(Game::Archive& Archive)
+    {
+        if (!EGL3_ENSURE(!Archive.GetHeader()->GetUpdateInfo().IsUpdating, LogLevel::Warning, "Can't revert an archive that's being updated")) {
+            return false;
+        }
+
+        Utils::Streams::FileStream Stream;
+        SnapshotHeader Header;
+        if (!OpenSnapshot(GetPath(Archive.GetPath()), Stream, Header)) {
+            return false;
+        }
+
+        Game::ArchiveList<Game::RunlistId::File> Files(Archive);
+        Game::ArchiveList<Game::RunlistId::ChunkPart> ChunkParts(Archive);
+        const Game::ArchiveList<Game::RunlistId::ChunkInfo> ChunkInfos(Archive);
+
+        // Chunks are only ever added while a snapshot is kept, the old indexes have to still be there
+        if (!EGL3_ENSURE(ChunkInfos.size() >= Header.ChunkInfoCount, LogLevel::Error, "Archive lost chunks since the snapshot was taken")) {
+            return false;
+        }
+
+        auto File = std::make_unique<Game::File[]>(Header.FileCount);
+        Stream.read((char*)File.get(), Header.FileCount * sizeof(Game::File));
+
+        auto ChunkPart = std::make_unique<Game::ChunkPart[]>(Header.ChunkPartCount);
+        Stream.read((char*)ChunkPart.get(), Header.ChunkPartCount * sizeof(Game::ChunkPart));
+
+        for (uint64_t i = 0; i < Header.ChunkPartCount; ++i) {
+            if (!EGL3_ENSURE(ChunkPart[i].ChunkIdx < Header.ChunkInfoCount, LogLevel::Error, "Archive snapshot references a chunk it didn't have")) {
+                return false;
+            }
+        }
+        Stream.close();
+
+        // Same order as an update, the lists are only trusted once the header stops saying it's updating
+        Archive.GetHeader()->GetUpdateInfo().IsUpdating = true;
+        Archive.Flush();
+
+        Files.resize(Header.FileCount);
+        Files.begin().FastWrite(File.get(), Header.FileCount);
+        ChunkParts.resize(Header.ChunkPartCount);
+        ChunkParts.begin().FastWrite(ChunkPart.get(), Header.ChunkPartCount);
+        Archive.Flush();
+
+        *Archive.GetManifestData() = Header.ManifestData;
+        *Archive.GetHeader() = Header.Header;
+        Archive.Flush();
+
+        EGL3_LOGF(LogLevel::Info, "Reverted {} to {}", Archive.GetPath(), Header.Header.GetVersionHR());
+
+        Delete(Archive.GetPath());
+        return true;
+    }
+
+    std::vector<uint32_t> ArchiveSnapshot::GetReferencedChunks(const std::filesystem::path& ArchivePath)
+    {
+        if (!Exists(ArchivePath)) {
+            return {};
+        }
+
+        Utils::Streams::FileStream Stream;
+        SnapshotHeader Header;
+        if (!OpenSnapshot(GetPath(ArchivePath), Stream, Header)) {
+            return {};
+        }
+
+        Stream.seek(Header.FileCount * sizeof(Game::File), Utils::Streams::Stream::Cur);
+
+        auto ChunkPart = std::make_unique<Game::ChunkPart[]>(Header.ChunkPartCount);
+        Stream.read((char*)ChunkPart.get(), Header.ChunkPartCount * sizeof(Game::ChunkPart));
+
+        std::vector<uint32_t> Ret;
+        Ret.reserve(Header.ChunkPartCount);
+        for (uint64_t i = 0; i < Header.ChunkPartCount; ++i) {
+            Ret.emplace_back(ChunkPart[i].ChunkIdx);
+        }
+        std::sort(Ret.begin(), Ret.end());
+        Ret.erase(std::unique(Ret.begin(), Ret.end()), Ret.end());
+        return Ret;
+    }
+
+    void ArchiveSnapshot::Delete(const std::filesystem::path& ArchivePath)
+    {
+        std::error_code Code;
+        if (std::filesystem::remove(GetPath(ArchivePath), Code)) {
+            EGL3_LOGF(LogLevel::Info, "Deleted the snapshot of {}", ArchivePath);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../game/Archive.h"
+
+#include <filesystem>
+#include <vector>
+
+namespace EGL3::Storage::Models {
+    // Keeps the previous version's header and file lists next to the archive (as <archive>.prev) so an update
+    // can be reverted without downloading anything
+    // Only valid as long as the chunks the old lists point to are left alone, updates that keep it may only
+    // replace chunks that GetReferencedChunks doesn't return, and other updates have to delete it before they start
+    class ArchiveSnapshot {
+    public:
+        static std::filesystem::path GetPath(const std::filesystem::path& ArchivePath);
+
+        static bool Exists(const std::filesystem::path& ArchivePath);
+
+        // The archive must not be in the middle of an update
+        static bool Save(Game::Archive& Archive);
+
+        // Puts the previous version's lists and header back and deletes the snapshot
+        static bool Revert(Game::Archive& Archive);
+
+        // Sorted indexes of the chunks the snapshot's lists point to, empty if there's no valid snapshot
+        static std::vector<uint32_t> GetReferencedChunks(const std::filesystem::path& ArchivePath);
+
+        static void Delete(const std::filesystem::path& ArchivePath);
+
+        static constexpr uint32_t ExpectedMagic = 0x56504745; // 'EGPV'
+    };
+}
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "ChunkReusePlan.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace EGL3::Storage::Models {
+    using namespace Web::Epic::BPS;
+
+    // Removes the elements of Data whose flag is set, keeping the order of the rest
+    template<class T>
+    static void EraseFlagged(std::vector<T>& Data, const std::vector<bool>& Flags) {
+        size_t Kept = 0;
+        for (size_t i = 0; i < Data.size(); ++i) {
+            if (!Flags[i]) {
+                Data[Kept++] = Data[i];
+            }
+        }
+        Data.erase(Data.begin() + Kept, Data.end());
+    }
+
+    ChunkReusePlan::ChunkReusePlan() :
+        BytesReused(0)
+    {
+
+    }
+
+    ChunkReusePlan::ChunkReusePlan(Game::Archive& Archive, const std::vector<std::reference_wrapper<const FileManifest>>& ManifestFiles, std::vector<std::reference_wrapper<const ChunkInfo>>& UpdatedChunks, std::vector<uint32_t>& DeletedChunkIdxs) :
+        BytesReused(0)
+    {
+        const Game::ArchiveList<Game::RunlistId::ChunkInfo> ChunkInfos(Archive);
+
+        PlanRelabels(ChunkInfos, UpdatedChunks, DeletedChunkIdxs);
+        PlanRebuilds(Archive, ManifestFiles, UpdatedChunks, DeletedChunkIdxs);
+
+        std::sort(SourceChunkIdxs.begin(), SourceChunkIdxs.end());
+        SourceChunkIdxs.erase(std::unique(SourceChunkIdxs.begin(), SourceChunkIdxs.end()), SourceChunkIdxs.end());
+        std::erase_if(DeletedChunkIdxs, [this](uint32_t Idx) {
+            return std::binary_search(SourceChunkIdxs.begin(), SourceChunkIdxs.end(), Idx);
+        });
+    }
+
+    void ChunkReusePlan::PlanRelabels(const Game::ArchiveList<Game::RunlistId::ChunkInfo>& ChunkInfos, std::vector<std::reference_wrapper<const ChunkInfo>>& UpdatedChunks, std::vector<uint32_t>& DeletedChunkIdxs)
+    {
+        // Chunk hashes are the rolling hash (Utils::RollingHash) of the whole window, so re-chunked data
+        // that lines up with an old chunk has the same hash under a different guid
+        std::vector<std::pair<uint64_t, uint32_t>> Candidates;
+        Candidates.reserve(DeletedChunkIdxs.size());
+        for (auto Idx : DeletedChunkIdxs) {
+            auto& Info = ChunkInfos[Idx];
+            if (Info.CompressedSize == Info.UncompressedSize) {
+                Candidates.emplace_back(Info.Hash, Idx);
+            }
+        }
+        if (Candidates.empty()) {
+            return;
+        }
+        std::sort(Candidates.begin(), Candidates.end());
+
+        std::vector<bool> CandidateUsed(Candidates.size());
+        std::vector<bool> Relabeled(UpdatedChunks.size());
+        for (size_t i = 0; i < UpdatedChunks.size(); ++i) {
+            auto& Chunk = UpdatedChunks[i].get();
+
+            auto Itr = std::lower_bound(Candidates.begin(), Candidates.end(), std::make_pair(Chunk.Hash, 0u));
+            for (; Itr != Candidates.end() && Itr->first == Chunk.Hash; ++Itr) {
+                auto CandidateIdx = Itr - Candidates.begin();
+                auto& Info = ChunkInfos[Itr->second];
+                if (CandidateUsed[CandidateIdx] || Info.UncompressedSize != Chunk.WindowSize || memcmp(Info.SHA, Chunk.SHAHash, sizeof(Info.SHA)) != 0) {
+                    continue;
+                }
+
+                CandidateUsed[CandidateIdx] = true;
+                Relabeled[i] = true;
+                Chunks.emplace_back(ReusedChunk{ .Chunk = Chunk, .RelabelIdx = Itr->second, .SourceIdx = 0, .SourceCount = 0 });
+                BytesReused += Chunk.WindowSize;
+                break;
+            }
+        }
+
+        EraseFlagged(UpdatedChunks, Relabeled);
+        std::erase_if(DeletedChunkIdxs, [&](uint32_t Idx) {
+            auto Itr = std::lower_bound(Candidates.begin(), Candidates.end(), std::make_pair(ChunkInfos[Idx].Hash, Idx));
+            return Itr != Candidates.end() && Itr->second == Idx && CandidateUsed[Itr - Candidates.begin()];
+        });
+    }
+
+    void ChunkReusePlan::PlanRebuilds(Game::Archive& Archive, const std::vector<std::reference_wrapper<const FileManifest>>& ManifestFiles, std::vector<std::reference_wrapper<const ChunkInfo>>& UpdatedChunks, const std::vector<uint32_t>& DeletedChunkIdxs)
+    {
+        // An unfinished update already replaced the file list, it doesn't describe the chunks anymore
+        if (Archive.GetHeader()->GetUpdateInfo().IsUpdating) {
+            return;
+        }
+
+        const Game::ArchiveList<Game::RunlistId::File> Files(Archive);
+        const Game::ArchiveList<Game::RunlistId::ChunkPart> ChunkParts(Archive);
+        const Game::ArchiveList<Game::RunlistId::ChunkInfo> ChunkInfos(Archive);
+        if (Files.empty() || UpdatedChunks.empty()) {
+            return;
+        }
+
+        std::unordered_map<std::string, uint32_t> FileLookup;
+        FileLookup.reserve(Files.size());
+        for (uint32_t i = 0; i < Files.size(); ++i) {
+            auto& File = Files[i];
+            if (File.FileSize) {
+                FileLookup.emplace(std::string(File.SHA, sizeof(File.SHA)), i);
+            }
+        }
+
+        std::vector<std::pair<Utils::Guid, uint32_t>> UpdatedLookup;
+        UpdatedLookup.reserve(UpdatedChunks.size());
+        for (uint32_t i = 0; i < UpdatedChunks.size(); ++i) {
+            UpdatedLookup.emplace_back(UpdatedChunks[i].get().Guid, i);
+        }
+        std::sort(UpdatedLookup.begin(), UpdatedLookup.end());
+
+        struct Section {
+            uint32_t UpdatedIdx;
+            uint32_t Offset;
+            uint32_t Size;
+            uint32_t FileIdx;
+            uint64_t FileOffset;
+        };
+
+        // Every part of an updated chunk that comes from a file whose contents didn't change
+        std::vector<Section> Sections;
+        for (const FileManifest& File : ManifestFiles) {
+            auto FileItr = FileLookup.find(std::string(File.FileHash, sizeof(File.FileHash)));
+            if (FileItr == FileLookup.end() || Files[FileItr->second].FileSize != File.FileSize) {
+                continue;
+            }
+
+            uint64_t FileOffset = 0;
+            for (auto& Part : File.ChunkParts) {
+                auto Itr = std::lower_bound(UpdatedLookup.begin(), UpdatedLookup.end(), std::make_pair(Part.Guid, 0u));
+                if (Itr != UpdatedLookup.end() && Itr->first == Part.Guid) {
+                    Sections.emplace_back(Section{ Itr->second, Part.Offset, Part.Size, FileItr->second, FileOffset });
+                }
+                FileOffset += Part.Size;
+            }
+        }
+        if (Sections.empty()) {
+            return;
+        }
+
+        std::sort(Sections.begin(), Sections.end(), [](const Section& A, const Section& B) {
+            if (A.UpdatedIdx != B.UpdatedIdx) {
+                return A.UpdatedIdx < B.UpdatedIdx;
+            }
+            if (A.Offset != B.Offset) {
+                return A.Offset < B.Offset;
+            }
+            return A.Size > B.Size;
+        });
+
+        std::vector<uint32_t> SortedDeletedIdxs(DeletedChunkIdxs);
+        std::sort(SortedDeletedIdxs.begin(), SortedDeletedIdxs.end());
+
+        // File offset of each old file's parts, only built for files that are read from
+        std::unordered_map<uint32_t, std::vector<uint64_t>> PartOffsets;
+        auto GetPartOffsets = [&](uint32_t FileIdx) -> const std::vector<uint64_t>& {
+            auto [Itr, Inserted] = PartOffsets.try_emplace(FileIdx);
+            if (Inserted) {
+                auto& File = Files[FileIdx];
+                Itr->second.reserve(File.ChunkPartDataSize);
+                uint64_t Offset = 0;
+                for (uint32_t i = 0; i < File.ChunkPartDataSize; ++i) {
+                    Itr->second.emplace_back(Offset);
+                    Offset += ChunkParts[(uint64_t)File.ChunkPartDataStartIdx + i].Size;
+                }
+            }
+            return Itr->second;
+        };
+
+        uint32_t SourceIdx = 0;
+
+        // Maps a byte range of an old file to the old chunks it's stored in, false if the archive doesn't have all of it
+        auto AddSources = [&](uint32_t FileIdx, uint64_t FileOffset, uint32_t Offset, uint32_t Size) {
+            auto& File = Files[FileIdx];
+            auto& Offsets = GetPartOffsets(FileIdx);
+
+            uint32_t i = std::upper_bound(Offsets.begin(), Offsets.end(), FileOffset) - Offsets.begin();
+            for (i = i ? i - 1 : 0; i < File.ChunkPartDataSize && Size; ++i) {
+                auto& Part = ChunkParts[(uint64_t)File.ChunkPartDataStartIdx + i];
+                if (Offsets[i] + Part.Size <= FileOffset) {
+                    continue;
+                }
+
+                if (Part.ChunkIdx >= ChunkInfos.size()) {
+                    return false;
+                }
+                auto& Info = ChunkInfos[Part.ChunkIdx];
+                if (Info.CompressedSize != Info.UncompressedSize || (uint64_t)Part.Offset + Part.Size > Info.UncompressedSize) {
+                    return false;
+                }
+
+                uint32_t PartSkip = uint32_t(FileOffset - Offsets[i]);
+                uint32_t Amount = std::min(Part.Size - PartSkip, Size);
+                uint32_t ChunkOffset = Part.Offset + PartSkip;
+
+                // Consecutive file parts are often consecutive in the same chunk too
+                if (Sources.size() > SourceIdx && Sources.back().ChunkIdx == Part.ChunkIdx && Sources.back().ChunkOffset + Sources.back().Size == ChunkOffset) {
+                    Sources.back().Size += Amount;
+                }
+                else {
+                    Sources.emplace_back(Source{ Part.ChunkIdx, ChunkOffset, Offset, Amount });
+                }
+
+                FileOffset += Amount;
+                Offset += Amount;
+                Size -= Amount;
+            }
+            return Size == 0;
+        };
+
+        std::vector<bool> Rebuilt(UpdatedChunks.size());
+        for (auto Itr = Sections.begin(); Itr != Sections.end();) {
+            auto UpdatedIdx = Itr->UpdatedIdx;
+            auto& Chunk = UpdatedChunks[UpdatedIdx].get();
+            SourceIdx = Sources.size();
+
+            // The same part of a chunk can be used by multiple files, only one copy is needed
+            bool Valid = true;
+            uint32_t Covered = 0;
+            for (; Itr != Sections.end() && Itr->UpdatedIdx == UpdatedIdx; ++Itr) {
+                uint32_t SectionEnd = Itr->Offset + Itr->Size;
+                if (!Valid || Itr->Offset > Covered || SectionEnd <= Covered) {
+                    continue;
+                }
+                auto Overlap = Covered - Itr->Offset;
+                Valid = AddSources(Itr->FileIdx, Itr->FileOffset + Overlap, Covered, Itr->Size - Overlap);
+                Covered = SectionEnd;
+            }
+
+            if (!Valid || Covered != Chunk.WindowSize) {
+                Sources.resize(SourceIdx);
+                continue;
+            }
+
+            for (auto SourceItr = Sources.begin() + SourceIdx; SourceItr != Sources.end(); ++SourceItr) {
+                if (std::binary_search(SortedDeletedIdxs.begin(), SortedDeletedIdxs.end(), SourceItr->ChunkIdx)) {
+                    SourceChunkIdxs.emplace_back(SourceItr->ChunkIdx);
+                }
+            }
+
+            Rebuilt[UpdatedIdx] = true;
+            Chunks.emplace_back(ReusedChunk{ .Chunk = Chunk, .RelabelIdx = uint32_t(-1), .SourceIdx = SourceIdx, .SourceCount = uint32_t(Sources.size() - SourceIdx) });
+            BytesReused += Chunk.WindowSize;
+        }
+
+        EraseFlagged(UpdatedChunks, Rebuilt);
+    }
+}
\ No newline at end of file
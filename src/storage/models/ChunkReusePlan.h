@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../../web/epic/bps/Manifest.h"
+#include "../game/ArchiveList.h"
+
+#include <functional>
+
+namespace EGL3::Storage::Models {
+    // Finds the updated chunks that can be rebuilt from data already in the archive instead of being downloaded
+    // Chunks with the same data as an unused chunk (rolling hash and sha) relabel that chunk in place
+    // Other chunks are gathered from the old chunks when every file they're taken from is unchanged (by sha)
+    class ChunkReusePlan {
+    public:
+        struct Source {
+            uint32_t ChunkIdx;      // Old chunk, index in the archive's chunk info list
+            uint32_t ChunkOffset;   // Offset in the old chunk's data
+            uint32_t Offset;        // Offset in the new chunk's data
+            uint32_t Size;
+        };
+
+        struct ReusedChunk {
+            std::reference_wrapper<const Web::Epic::BPS::ChunkInfo> Chunk;
+            // Unused chunk to relabel, or -1 if the chunk is rebuilt from its sources
+            uint32_t RelabelIdx;
+            uint32_t SourceIdx;
+            uint32_t SourceCount;
+
+            bool IsRelabel() const {
+                return RelabelIdx != uint32_t(-1);
+            }
+        };
+
+        ChunkReusePlan();
+
+        // Must be created before the archive's file list is replaced with the new one
+        // UpdatedChunks and DeletedChunkIdxs are trimmed of everything the plan takes care of
+        ChunkReusePlan(Game::Archive& Archive, const std::vector<std::reference_wrapper<const Web::Epic::BPS::FileManifest>>& ManifestFiles, std::vector<std::reference_wrapper<const Web::Epic::BPS::ChunkInfo>>& UpdatedChunks, std::vector<uint32_t>& DeletedChunkIdxs);
+
+        std::vector<ReusedChunk> Chunks;
+        std::vector<Source> Sources;
+        // Unused chunks that are read from, they can't be replaced until every rebuilt chunk is written
+        std::vector<uint32_t> SourceChunkIdxs;
+        uint64_t BytesReused;
+
+    private:
+        void PlanRelabels(const Game::ArchiveList<Game::RunlistId::ChunkInfo>& ChunkInfos, std::vector<std::reference_wrapper<const Web::Epic::BPS::ChunkInfo>>& UpdatedChunks, std::vector<uint32_t>& DeletedChunkIdxs);
+
+        void PlanRebuilds(Game::Archive& Archive, const std::vector<std::reference_wrapper<const Web::Epic::BPS::FileManifest>>& ManifestFiles, std::vector<std::reference_wrapper<const Web::Epic::BPS::ChunkInfo>>& UpdatedChunks, const std::vector<uint32_t>& DeletedChunkIdxs);
+    };
+}
\ No newline at end of file
@@ -4,18 +4,55 @@
 #include "../../web/epic/EpicClient.h"
 #include "../../utils/Align.h"
 #include "../../utils/Config.h"
+#include "../../utils/SHA.h"
 #include "../../utils/Taskbar.h"
+#include "../../utils/mmio/WorkingSetGovernor.h"
+#include "../game/LaunchFiles.h"
+#include "ArchiveSnapshot.h"
+#include "FileTableBuilder.h"
 
+#include <algorithm>
 #include <charconv>
+#include <numeric>
 #include <regex>
+#include <thread>
 
 namespace EGL3::Storage::Models {
     static constexpr std::chrono::milliseconds RefreshTime(500);
     static constexpr double DivideRate = std::chrono::duration_cast<std::chrono::duration<double>>(RefreshTime) / std::chrono::seconds(1);
+    static constexpr int MaxChunkAttempts = 5;
+    static constexpr std::chrono::milliseconds ChunkRetryDelay(250);
+    static constexpr std::chrono::milliseconds CancelCheckInterval(50);
 
-    DownloadInfo::DownloadInfo(Game::GameId Id, InstalledGame* GameConfig) :
+    // Chunk data the install will allocate past the end of what's already in the archive
+    // Exact for new installs, for updates it assumes the largest chunks are the ones that don't get a deleted chunk's slot
+    static uint64_t GetNewChunkDataSize(const DownloadInfo::StateInstalling& Data)
+    {
+        std::vector<uint64_t> Sizes;
+        Sizes.reserve(Data.Scheduler.size() + Data.ReusePlan.Chunks.size());
+        for (auto& Chunk : Data.Scheduler.GetQueue()) {
+            Sizes.emplace_back(Utils::Align<Game::Header::GetSectorSize()>(Chunk.get().WindowSize));
+        }
+        for (auto& Reused : Data.ReusePlan.Chunks) {
+            if (!Reused.IsRelabel()) {
+                Sizes.emplace_back(Utils::Align<Game::Header::GetSectorSize()>(Reused.Chunk.get().WindowSize));
+            }
+        }
+
+        if (Sizes.size() <= Data.DeletedChunkIdxs.size()) {
+            return 0;
+        }
+
+        auto NewCount = Sizes.size() - Data.DeletedChunkIdxs.size();
+        std::nth_element(Sizes.begin(), Sizes.begin() + NewCount, Sizes.end(), std::greater<>());
+        return std::accumulate(Sizes.begin(), Sizes.begin() + NewCount, 0ull);
+    }
+
+    DownloadInfo::DownloadInfo(Game::GameId Id, InstalledGame* GameConfig, Utils::RateLimiter* GlobalNetworkLimiter, Utils::RateLimiter* GlobalWriteLimiter) :
         Id(Id),
         GameConfig(GameConfig),
+        NetworkLimiter(GlobalNetworkLimiter),
+        WriteLimiter(GlobalWriteLimiter),
         CurrentState(DownloadInfoState::Options),
         StateData(StateOptions(Id))
     {
@@ -36,8 +73,8 @@ namespace EGL3::Storage::Models {
     {
         SetDownloadCancelled();
 
-        if (PrimaryTask.valid()) {
-            PrimaryTask.get();
+        if (PrimaryThread.joinable()) {
+            PrimaryThread.join();
         }
     }
 
@@ -57,38 +94,14 @@ namespace EGL3::Storage::Models {
         SetState(DownloadInfoState::Cancelled);
     }
 
-    template<typename Comparer>
-    struct GuidComparer {
-        const Game::ArchiveList<Game::RunlistId::ChunkInfo>& ArchiveChunks;
-
-        GuidComparer(const Game::ArchiveList<Game::RunlistId::ChunkInfo>& ArchiveChunks) :
-            ArchiveChunks(ArchiveChunks)
-        {
-
-        }
-
-        template<class T>
-        const Utils::Guid& Convert(const T& Val) const = delete;
-
-        template<>
-        const Utils::Guid& Convert<uint32_t>(const uint32_t& Val) const {
-            return ArchiveChunks[Val].Guid;
-        }
-
-        template<>
-        const Utils::Guid& Convert<std::reference_wrapper<const Utils::Guid>>(const std::reference_wrapper<const Utils::Guid>& Val) const {
-            return Val;
-        }
-
-        template<class TA, class TB>
-        bool operator()(const TA& A, const TB& B) const {
-            return Comparer{}(Convert(A), Convert(B));
-        }
-    };
+    void DownloadInfo::SetSharedArchives(std::vector<std::filesystem::path>&& ArchivePaths)
+    {
+        SharedArchivePaths = std::move(ArchivePaths);
+    }
 
     void DownloadInfo::BeginDownload(const LatestManifestRequest& GetLatestManifest, const CreateGameConfig& CreateGameConfig)
     {
-        PrimaryTask = std::async(std::launch::async, [GetLatestManifest, CreateGameConfig, this]() {
+        PrimaryThread = std::thread([GetLatestManifest, CreateGameConfig, this]() {
             {
                 if (!GameConfig) {
                     GameConfig = &CreateGameConfig();
@@ -128,12 +141,13 @@ namespace EGL3::Storage::Models {
 
                 const Game::ArchiveList<Game::RunlistId::ChunkInfo> ChunkInfo(*Archive);
 
-                // Get a simple sequence from 0...ChunkInfo-1
-                std::vector<uint32_t> ArchiveGuids;
-                ArchiveGuids.reserve(ChunkInfo.size());
+                // Guids of the chunks in the archive, in runlist order
+                std::vector<Utils::Guid> ArchiveGuidList;
+                ArchiveGuidList.reserve(ChunkInfo.size());
                 for (uint32_t i = 0; i < ChunkInfo.size(); ++i) {
-                    ArchiveGuids.emplace_back(i);
+                    ArchiveGuidList.emplace_back(ChunkInfo[i].Guid);
                 }
+                Utils::GuidSet ArchiveGuids(std::vector<Utils::Guid>(ArchiveGuidList));
 
                 // Get all files that will be installed
                 std::vector<std::reference_wrapper<const Web::Epic::BPS::FileManifest>> ManifestFiles;
@@ -144,38 +158,97 @@ namespace EGL3::Storage::Models {
                 }
 
                 // Get all required chunks that need to be installed
-                std::vector<std::reference_wrapper<const Utils::Guid>> ManifestGuids;
-                for (const Web::Epic::BPS::FileManifest& File : ManifestFiles) {
-                    for (auto& Part : File.ChunkParts) {
-                        ManifestGuids.emplace_back(Part.Guid);
+                Utils::GuidSet ManifestGuids;
+                {
+                    std::vector<Utils::Guid> RequiredGuids;
+                    for (const Web::Epic::BPS::FileManifest& File : ManifestFiles) {
+                        for (auto& Part : File.ChunkParts) {
+                            RequiredGuids.emplace_back(Part.Guid);
+                        }
                     }
+                    ManifestGuids = Utils::GuidSet(std::move(RequiredGuids));
                 }
 
                 // Get all chunks to be updated/added to the archive and all that need to be removed/replaced
-                GuidComparer<std::less<Utils::Guid>> Comparer(ChunkInfo);
-
-                std::sort(ArchiveGuids.begin(), ArchiveGuids.end(), Comparer);
-                std::sort(ManifestGuids.begin(), ManifestGuids.end(), Comparer);
-                // std::unique only removes consecutive copies (different chunk parts using the same chunk), so it has to be sorted first.
-                // It also doesn't remove anything, so we have to erase it manually
-                ManifestGuids.erase(std::unique(ManifestGuids.begin(), ManifestGuids.end(), GuidComparer<std::equal_to<Utils::Guid>>(ChunkInfo)), ManifestGuids.end());
+                // Walking the manifest's chunk list directly avoids a linear Manifest::GetChunk per updated guid
+                // UpdatedChunks is in the manifest's chunk order, nothing after this depends on it being sorted by guid
+                std::vector<std::reference_wrapper<const Web::Epic::BPS::ChunkInfo>> UpdatedChunks;
+                for (auto& Chunk : Manifest->ChunkDataList.ChunkList) {
+                    if (!ArchiveGuids.Contains(Chunk.Guid) && ManifestGuids.Contains(Chunk.Guid)) {
+                        UpdatedChunks.emplace_back(Chunk);
+                    }
+                }
 
-                std::vector<std::reference_wrapper<const Utils::Guid>> UpdatedGuids;
                 std::vector<uint32_t> DeletedChunkIdxs;
+                for (uint32_t i = 0; i < ArchiveGuidList.size(); ++i) {
+                    if (!ManifestGuids.Contains(ArchiveGuidList[i])) {
+                        DeletedChunkIdxs.emplace_back(i);
+                    }
+                }
 
-                std::set_difference(ManifestGuids.begin(), ManifestGuids.end(), ArchiveGuids.begin(), ArchiveGuids.end(), std::back_inserter(UpdatedGuids), Comparer);
-                std::set_difference(ArchiveGuids.begin(), ArchiveGuids.end(), ManifestGuids.begin(), ManifestGuids.end(), std::back_inserter(DeletedChunkIdxs), Comparer);
+                // The same chunk can be in the archive more than once, only its first copy is kept and the rest are replaced
+                // ArchiveGuids drops duplicates, so the sizes only differ if there are any
+                if (ArchiveGuids.size() != ArchiveGuidList.size()) {
+                    std::vector<uint32_t> GuidOrder(ArchiveGuidList.size());
+                    std::iota(GuidOrder.begin(), GuidOrder.end(), 0);
+                    std::stable_sort(GuidOrder.begin(), GuidOrder.end(), [&](uint32_t A, uint32_t B) {
+                        return ArchiveGuidList[A] < ArchiveGuidList[B];
+                    });
+
+                    for (size_t i = 1; i < GuidOrder.size(); ++i) {
+                        auto& Guid = ArchiveGuidList[GuidOrder[i]];
+                        // Ones the manifest doesn't use are already deleted above
+                        if (Guid == ArchiveGuidList[GuidOrder[i - 1]] && ManifestGuids.Contains(Guid)) {
+                            DeletedChunkIdxs.emplace_back(GuidOrder[i]);
+                        }
+                    }
+                    std::sort(DeletedChunkIdxs.begin(), DeletedChunkIdxs.end());
+                }
 
-                std::vector<std::reference_wrapper<const Web::Epic::BPS::ChunkInfo>> UpdatedChunks;
-                for (auto& Guid : UpdatedGuids) {
-                    auto Chunk = Manifest->GetChunk(Guid);
-                    if (Chunk) {
-                        UpdatedChunks.emplace_back(*Chunk);
+                // Reads the archive's current file list, which stays as is until FileTableBuilder replaces it when the install finishes
+                ChunkReusePlan ReusePlan(*Archive, ManifestFiles, UpdatedChunks, DeletedChunkIdxs);
+                if (!ReusePlan.Chunks.empty()) {
+                    EGL3_LOGF(LogLevel::Info, "Reusing {} chunks ({} bytes) already in the archive, {} chunks left to install", ReusePlan.Chunks.size(), ReusePlan.BytesReused, UpdatedChunks.size());
+                }
+
+                // Keeping the previous version means leaving every chunk it uses where it is
+                // Chunks only older versions used aren't in the new snapshot, so they're freed like any other update's
+                if (GameConfig->GetFlag<InstallFlags::KeepPreviousVersion>()) {
+                    // A resumed update already saved it when it started
+                    if (!Archive->GetHeader()->GetUpdateInfo().IsUpdating && Archive->GetHeader()->GetVersionNum()) {
+                        if (!ArchiveSnapshot::Save(*Archive)) {
+                            ArchiveSnapshot::Delete(GameConfig->GetPath());
+                        }
                     }
+
+                    auto KeptChunkIdxs = ArchiveSnapshot::GetReferencedChunks(GameConfig->GetPath());
+                    auto IsKept = [&KeptChunkIdxs](uint32_t Idx) {
+                        return std::binary_search(KeptChunkIdxs.begin(), KeptChunkIdxs.end(), Idx);
+                    };
+                    std::erase_if(DeletedChunkIdxs, IsKept);
+                    std::erase_if(ReusePlan.SourceChunkIdxs, IsKept);
+                }
+                else {
+                    ArchiveSnapshot::Delete(GameConfig->GetPath());
+                }
+
+                // Files still wait on reused chunks, they're just not downloaded
+                std::vector<Utils::Guid> ReusedGuids;
+                ReusedGuids.reserve(ReusePlan.Chunks.size());
+                for (auto& Reused : ReusePlan.Chunks) {
+                    ReusedGuids.emplace_back(Reused.Chunk.get().Guid);
                 }
+                InstallScheduler Scheduler(ManifestFiles, { Manifest->ManifestMeta.LaunchExe }, Game::LaunchFiles::Load(GameConfig->GetPath()).GetFiles(), std::move(UpdatedChunks), ReusedGuids);
+
+                // The archive being installed to is already open for writing, it can't be read from this way
+                std::erase_if(SharedArchivePaths, [this](const std::filesystem::path& Path) {
+                    std::error_code Code;
+                    return Path == GameConfig->GetPath() || std::filesystem::equivalent(Path, GameConfig->GetPath(), Code);
+                });
+                ArchiveChunkProvider ArchiveProvider(SharedArchivePaths);
 
                 Utils::EGL::ChunkProvider EGLProvider(std::move(Data.EGLProvider));
-                StateData.emplace<StateInstalling>(std::move(CloudDir), std::move(Manifest.value()), std::move(ManifestFiles), *Archive, std::move(UpdatedChunks), std::move(DeletedChunkIdxs), std::move(EGLProvider));
+                StateData.emplace<StateInstalling>(std::move(CloudDir), std::move(Manifest.value()), std::move(ManifestFiles), *Archive, std::move(Scheduler), std::move(DeletedChunkIdxs), std::move(ReusePlan), std::move(EGLProvider), std::move(ArchiveProvider));
             }
 
             {
@@ -184,43 +257,31 @@ namespace EGL3::Storage::Models {
 
                 Game::UpdateInfo OldUpdateInfo(Data.Archive.GetHeader()->GetUpdateInfo());
 
-                InitializeArchive(Id, Data.Manifest.ManifestMeta, Data.CloudDir, Data.Archive.GetHeader(), Data.Archive.GetManifestData());
+                // Has to be on disk before any of the lists change
+                BeginArchiveUpdate(Id, Data.Manifest.ManifestMeta, Data.Archive.GetHeader());
+                Data.Archive.Flush();
 
-                // TODO: move this into the "finalizing", it's not of any use during the update anyway
-                {
-                    Data.ArchiveFiles.resize(Data.ManifestFiles.size());
-                    uint64_t TotalChunkParts = std::accumulate(Data.ManifestFiles.begin(), Data.ManifestFiles.end(), 0ull,
-                        [](uint64_t Val, const Web::Epic::BPS::FileManifest& File) { return Val + File.ChunkParts.size(); });
-                    Data.ArchiveChunkParts.resize(TotalChunkParts);
-
-                    uint32_t NextAvailableChunkPartIdx = 0;
-                    uint32_t i = 0;
-                    for (const Web::Epic::BPS::FileManifest& File : Data.ManifestFiles) {
-                        auto& ArchiveFile = Data.ArchiveFiles[i++];
-                        strncpy_s(ArchiveFile.Filename, File.Filename.c_str(), File.Filename.size());
-                        memcpy(ArchiveFile.SHA, File.FileHash, 20);
-                        ArchiveFile.FileSize = File.FileSize;
-                        ArchiveFile.ChunkPartDataStartIdx = NextAvailableChunkPartIdx;
-                        ArchiveFile.ChunkPartDataSize = File.ChunkParts.size();
-
-                        uint32_t j = 0;
-                        for (auto& ChunkPart : File.ChunkParts) {
-                            auto& ArchiveChunkPart = Data.ArchiveChunkParts[(uint64_t)ArchiveFile.ChunkPartDataStartIdx + j++];
-                            ArchiveChunkPart.ChunkIdx = 0;
-                            ArchiveChunkPart.Offset = ChunkPart.Offset;
-                            ArchiveChunkPart.Size = ChunkPart.Size;
-                        }
+                Data.ArchiveChunkInfos.reserve(Data.Manifest.ChunkDataList.ChunkList.size());
 
-                        NextAvailableChunkPartIdx += File.ChunkParts.size();
+                // Reserving it all now gives the chunk data one run and extends the file once, instead of once per chunk
+                // The reservation is only allocated, the runlist's size grows as sectors are handed out. If the install
+                // is interrupted, the sectors that weren't handed out are picked up again by the next one
+                {
+                    auto NewChunkDataSize = GetNewChunkDataSize(Data);
+                    auto ChunkDataStart = Utils::Align<Game::Header::GetSectorSize()>(Data.ArchiveChunkDatas.size());
+                    Data.ChunkDataCursor.store(ChunkDataStart);
+                    Data.ChunkDataSize.store(Data.ArchiveChunkDatas.size());
+                    if (NewChunkDataSize) {
+                        Data.ArchiveChunkDatas.reserve(ChunkDataStart + NewChunkDataSize);
+                        EGL3_LOGF(LogLevel::Info, "Reserved {} bytes for chunk data", NewChunkDataSize);
                     }
                 }
 
-                Data.ArchiveChunkInfos.reserve(Data.Manifest.ChunkDataList.ChunkList.size());
-
                 Data.Pool.Task.Set([this]() { return InstallOne(); });
                 Data.Pool.SetRunning();
+                EGL3_LOGF(LogLevel::Info, "Installing with {} tasks", Data.Pool.GetCapacity());
 
-                if (OldUpdateInfo.IsUpdating && OldUpdateInfo.TargetVersion == Data.Archive.GetHeader()->GetVersionNum()) {
+                if (OldUpdateInfo.IsUpdating && OldUpdateInfo.TargetVersion == Data.Archive.GetHeader()->GetUpdateInfo().TargetVersion) {
                     BeginTimestamp -= std::chrono::nanoseconds(OldUpdateInfo.NanosecondsElapsed);
 
                     Data.PiecesTotal += OldUpdateInfo.PiecesComplete;
@@ -248,18 +309,35 @@ namespace EGL3::Storage::Models {
                     uint64_t BytesDownloadTotal = Data.BytesDownloadTotal.load(std::memory_order::relaxed);
                     uint64_t BytesReadTotal = Data.BytesReadTotal.load(std::memory_order::relaxed);
                     uint64_t BytesWriteTotal = Data.BytesWriteTotal.load(std::memory_order::relaxed);
+                    uint32_t LaunchFilesComplete;
+                    {
+                        std::lock_guard Guard(Data.DataMutex);
+                        LaunchFilesComplete = Data.Scheduler.GetResidentLaunchFileCount();
+                    }
+
+                    // Trims the archive's cold pages before the install pushes out the rest of the system's
+                    auto& Governor = Utils::Mmio::WorkingSetGovernor::Get();
+                    Governor.Enforce();
 
                     DownloadInfoStats Stats{
                         .State = CurrentState,
                         .NanosecondStartTimestamp = (uint64_t)BeginTimestamp.time_since_epoch().count(),
                         .NanosecondCurrentTimestamp = (uint64_t)NextUpdateTime.time_since_epoch().count(),
                         .PiecesTotal = Data.PiecesTotal,
-                        .DownloadTotal = Data.DownloadTotal,
+                        .DownloadTotal = Data.DownloadTotal.load(std::memory_order::relaxed),
+                        .ReadTotal = Data.ReadTotal.load(std::memory_order::relaxed),
+                        .WriteTotal = Data.WriteTotal.load(std::memory_order::relaxed),
                         .PiecesComplete = PiecesComplete,
                         .BytesDownloadTotal = BytesDownloadTotal,
+                        .BytesReadTotal = BytesReadTotal,
+                        .BytesWriteTotal = BytesWriteTotal,
                         .BytesDownloadRate = uint64_t((BytesDownloadTotal - Data.BytesDownloadTotalLast) / DivideRate),
                         .BytesReadRate = uint64_t((BytesReadTotal - Data.BytesReadTotalLast) / DivideRate),
                         .BytesWriteRate = uint64_t((BytesWriteTotal - Data.BytesWriteTotalLast) / DivideRate),
+                        .LaunchFilesTotal = Data.Scheduler.GetLaunchFileCount(),
+                        .LaunchFilesComplete = LaunchFilesComplete,
+                        .MappedResidentBytes = Governor.GetStats().ResidentBytes,
+                        .MappedDirtyBytes = Data.Archive.GetPendingWriteBackBytes(),
                     };
                     Data.BytesDownloadTotalLast = BytesDownloadTotal;
                     Data.BytesReadTotalLast = BytesReadTotal;
@@ -286,30 +364,20 @@ namespace EGL3::Storage::Models {
                 if (!Data.Cancelled) {
                     SetState(DownloadInfoState::Finishing);
 
-                    std::unordered_map<std::reference_wrapper<const Utils::Guid>, uint32_t, std::hash<Utils::Guid>, std::equal_to<Utils::Guid>> ChunkLookup;
-                    ChunkLookup.reserve(Data.ArchiveChunkInfos.size());
-
-                    uint32_t i = 0;
-                    for (auto& Chunk : Data.ArchiveChunkInfos) {
-                        ChunkLookup.emplace(Chunk.Guid, i++);
-                    }
-
-                    i = 0;
-                    for (const Web::Epic::BPS::FileManifest& File : Data.ManifestFiles) {
-                        auto& ArchiveFile = Data.ArchiveFiles[i++];
-
-                        uint32_t j = 0;
-                        for (auto& ChunkPart : File.ChunkParts) {
-                            auto& ArchiveChunkPart = Data.ArchiveChunkParts[(uint64_t)ArchiveFile.ChunkPartDataStartIdx + j++];
-                            ArchiveChunkPart.ChunkIdx = ChunkLookup.at(ChunkPart.Guid);
-                        }
-                    }
+                    // The file list is only valid once every chunk has an index, IsUpdating stays set until it's written
+                    FileTableBuilder FileTable(Data.ArchiveFiles, Data.ArchiveChunkParts, Data.ArchiveChunkInfos, Data.ManifestFiles);
+                    EGL3_LOGF(LogLevel::Info, "Wrote {} of {} files and {} chunk parts that changed", FileTable.FilesWritten, Data.ManifestFiles.size(), FileTable.ChunkPartsWritten);
 
-                    Data.Archive.GetHeader()->GetUpdateInfo().IsUpdating = false;
+                    // The lists have to be on disk before the header says they're valid
+                    Data.Archive.Flush();
+                    CommitArchiveUpdate(Id, Data.Manifest.ManifestMeta, Data.CloudDir, Data.Archive.GetHeader(), Data.Archive.GetManifestData());
                 }
 
                 Data.Archive.Flush();
 
+                EGL3_LOGF(LogLevel::Info, "Install took {}s, {} bytes downloaded with {} chunk retries", std::chrono::duration_cast<std::chrono::seconds>(NextUpdateTime - BeginTimestamp).count(), Data.BytesDownloadTotal.load(), Data.ChunkRetries.load());
+                EGL3_LOGF(LogLevel::Info, "{} bytes of mapped archives have been trimmed from the working set so far", Utils::Mmio::WorkingSetGovernor::Get().GetStats().TrimmedBytes);
+
                 GameConfig->CloseArchive();
 
                 SetState(Data.Cancelled ? DownloadInfoState::Cancelled : DownloadInfoState::Finished);
@@ -341,6 +409,10 @@ namespace EGL3::Storage::Models {
         }
         SetState(DownloadInfoState::Cancelling);
 
+        // Installs waiting out rate limit debt would otherwise hold up the cancel
+        NetworkLimiter.Cancel();
+        WriteLimiter.Cancel();
+
         DataPtr->Pool.SetRunning(); // They need to run in order to exit
     }
 
@@ -361,64 +433,118 @@ namespace EGL3::Storage::Models {
             return false;
         }
 
-        if (!Data.UpdatedChunks.empty()) {
-            auto& Chunk = Pop(Data.UpdatedChunks).get();
+        if (!Data.ReusePlan.Chunks.empty()) {
+            auto Reused = Pop(Data.ReusePlan.Chunks);
+            auto& Chunk = Reused.Chunk.get();
             OnChunkUpdate(Chunk.Guid, ChunkState::Initializing);
 
-            if (!Data.DeletedChunkIdxs.empty()) {
-                uint32_t ReplaceIdx = Pop(Data.DeletedChunkIdxs);
+            bool Installed;
+            if (Reused.IsRelabel()) {
                 Lock.unlock();
 
-                auto& ChunkInfoData = Data.ArchiveChunkInfos[ReplaceIdx];
-
-                // Original chunk doesn't have enough space for the new chunk data
-                if (Chunk.WindowSize > ChunkInfoData.UncompressedSize) {
-                    ChunkInfoData.DataSector = AllocateChunkData(Chunk.WindowSize);
-                }
-
-                Data.BytesReadTotal.fetch_add(sizeof(ChunkInfoData), std::memory_order::relaxed);
-
-                InstallOne(Chunk, ChunkInfoData);
+                Installed = ReuseOne(Reused, Data.ArchiveChunkInfos[Reused.RelabelIdx]);
             }
             else {
-                Lock.unlock();
+                Installed = ReuseOne(Reused, AcquireChunkInfo(Chunk, Lock));
+            }
 
-                auto& ChunkInfoData = AllocateChunkInfo();
+            // A cancelled install is never resumed in this state, so the acquired chunk info isn't given back
+            // It isn't written either, the next install's planner sees it as unused and replaces it
+            if (!Installed) {
+                return false;
+            }
 
-                ChunkInfoData.DataSector = AllocateChunkData(Chunk.WindowSize);
+            Lock.lock();
+            // Nothing reads from the old chunks anymore, they can be replaced now
+            if (--Data.ReusePending == 0) {
+                Data.DeletedChunkIdxs.insert(Data.DeletedChunkIdxs.begin(), Data.ReusePlan.SourceChunkIdxs.begin(), Data.ReusePlan.SourceChunkIdxs.end());
+            }
+            OnChunkInstalled(Chunk);
+            Lock.unlock();
+
+            ++Data.PiecesComplete;
+            return true;
+        }
+        else if (!Data.Scheduler.empty()) {
+            auto& Chunk = Data.Scheduler.Pop().get();
+            OnChunkUpdate(Chunk.Guid, ChunkState::Initializing);
 
-                InstallOne(Chunk, ChunkInfoData);
+            if (!InstallOne(Chunk, AcquireChunkInfo(Chunk, Lock))) {
+                return false;
             }
 
+            Lock.lock();
+            OnChunkInstalled(Chunk);
+            Lock.unlock();
+
             ++Data.PiecesComplete;
             return true;
         }
         else {
             // remove unused deleted chunks later, that's too much work atm
             // for now, we only replace them
-            auto Size = Data.DeletedChunkIdxs.size();
+            auto Size = Data.DeletedChunkIdxs.size() + (Data.ReusePending ? Data.ReusePlan.SourceChunkIdxs.size() : 0);
             EGL3_ENSUREF(Size == 0, LogLevel::Warning, "{} undeleted chunks remain. This is untested, in the worst case, your install could become corrupted", Size);
             return false;
         }
     }
 
-    void DownloadInfo::InstallOne(const Web::Epic::BPS::ChunkInfo& Chunk, Storage::Game::ChunkInfo& ChunkInfoData)
+    void DownloadInfo::OnChunkInstalled(const Web::Epic::BPS::ChunkInfo& Chunk)
+    {
+        auto& Data = GetStateData<StateInstalling>();
+
+        if (Data.Scheduler.OnChunkInstalled(Chunk.Guid)) {
+            EGL3_LOGF(LogLevel::Info, "All {} launch files are installed", Data.Scheduler.GetLaunchFileCount());
+        }
+    }
+
+    bool DownloadInfo::InstallOne(const Web::Epic::BPS::ChunkInfo& Chunk, Storage::Game::ChunkInfo& ChunkInfoData)
     {
         auto& Data = GetStateData<StateInstalling>();
 
+        auto BeginChunkDataItr = Data.ArchiveChunkDatas.begin() + ChunkInfoData.DataSector * Game::Header::GetSectorSize();
+
         std::unique_ptr<char[]> ChunkData;
 
-        if (Data.EGLProvider.IsValid()) {
+        // Another archive having the same data is the cheapest source, it's one copy with nothing to decompress
+        bool ExpectedFromArchive = Data.ArchiveProvider.IsChunkAvailable(Chunk);
+        if (ExpectedFromArchive) {
             OnChunkUpdate(Chunk.Guid, ChunkState::Transferring);
 
-            ChunkData = Data.EGLProvider.GetChunk(Chunk.Guid);
+            ChunkData = std::make_unique<char[]>(Chunk.WindowSize);
+            if (!Data.ArchiveProvider.ReadChunk(Chunk, ChunkData.get())) {
+                ChunkData.reset();
+            }
             Data.BytesReadTotal.fetch_add((uint64_t)Chunk.WindowSize, std::memory_order::relaxed);
         }
 
-        if (!ChunkData) {
+        bool ExpectedFromProvider = !ExpectedFromArchive && Data.EGLProvider.IsValid() && Data.EGLProvider.IsChunkProbablyAvailable(Chunk.Guid);
+        bool WrittenFromProvider = false;
+        if (ExpectedFromProvider) {
+            OnChunkUpdate(Chunk.Guid, ChunkState::Transferring);
+
+            WriteLimiter.Acquire(Chunk.WindowSize);
+
+            // Sections are copied straight from the install's files into the archive
+            // If the chunk doesn't verify, the download below overwrites whatever was written
+            WrittenFromProvider = Data.EGLProvider.ReadChunk(Chunk.Guid, [&](uint32_t ChunkOffset, const char* Section, uint32_t Size) {
+                (BeginChunkDataItr + ChunkOffset).FastWrite(Section, Size);
+            });
+            Data.BytesReadTotal.fetch_add((uint64_t)Chunk.WindowSize, std::memory_order::relaxed);
+        }
+
+        if (!WrittenFromProvider && !ChunkData) {
             OnChunkUpdate(Chunk.Guid, ChunkState::Downloading);
 
+            if (ExpectedFromArchive || ExpectedFromProvider) {
+                Data.DownloadTotal.fetch_add(Chunk.FileSize, std::memory_order::relaxed);
+            }
+
             auto Resp = GetChunk(Chunk);
+            if (Resp.HasError() && Resp.GetErrorCode() == Web::ErrorData::Status::Cancelled) {
+                // Nothing was written, a resumed install gets it again
+                return false;
+            }
             EGL3_VERIFY(!Resp.HasError(), "Could not get chunk");
             EGL3_VERIFY(!Resp->HasError(), "Could not parse chunk");
 
@@ -429,35 +555,95 @@ namespace EGL3::Storage::Models {
             ChunkData = std::move(Resp->Data);
         }
 
-        OnChunkUpdate(Chunk.Guid, ChunkState::WritingMetadata);
-
-        ChunkInfoData.Guid = Chunk.Guid;
-        memcpy(ChunkInfoData.SHA, Chunk.SHAHash, 20);
-        ChunkInfoData.UncompressedSize = Chunk.WindowSize;
-        ChunkInfoData.CompressedSize = Chunk.WindowSize;
-        // ChunkInfoData.DataSector
-        ChunkInfoData.Hash = Chunk.Hash;
-        ChunkInfoData.DataGroup = Chunk.GroupNumber;
-
-        Data.BytesWriteTotal.fetch_add(sizeof(ChunkInfoData), std::memory_order::relaxed);
+        WriteChunkInfo(Chunk, ChunkInfoData);
 
         OnChunkUpdate(Chunk.Guid, ChunkState::WritingData);
 
-        auto BeginChunkDataItr = Data.ArchiveChunkDatas.begin() + ChunkInfoData.DataSector * Game::Header::GetSectorSize();
-        BeginChunkDataItr.FastWrite(ChunkData.get(), Chunk.WindowSize);
-        // Data.ArchiveChunkDatas.flush(BeginChunkDataItr, Chunk.WindowSize);
+        if (ChunkData) {
+            WriteLimiter.Acquire(Chunk.WindowSize);
+            BeginChunkDataItr.FastWrite(ChunkData.get(), Chunk.WindowSize);
+        }
+        // Only queues the range, the archive writes queued ranges back in batches
+        Data.ArchiveChunkDatas.flush(BeginChunkDataItr, Chunk.WindowSize);
 
         Data.BytesWriteTotal.fetch_add(Chunk.WindowSize, std::memory_order::relaxed);
 
         OnChunkUpdate(Chunk.Guid, ChunkState::Completed);
+        return true;
+    }
+
+    bool DownloadInfo::ReuseOne(const ChunkReusePlan::ReusedChunk& Reused, Storage::Game::ChunkInfo& ChunkInfoData)
+    {
+        auto& Data = GetStateData<StateInstalling>();
+        auto& Chunk = Reused.Chunk.get();
+
+        OnChunkUpdate(Chunk.Guid, ChunkState::Transferring);
+
+        auto ChunkData = std::make_unique<char[]>(Chunk.WindowSize);
+        auto BeginChunkDataItr = Data.ArchiveChunkDatas.begin();
+
+        if (Reused.IsRelabel()) {
+            // The data is already in place, it only needs to be checked
+            (BeginChunkDataItr + ChunkInfoData.DataSector * Game::Header::GetSectorSize()).FastRead(ChunkData.get(), Chunk.WindowSize);
+        }
+        else {
+            auto SourcesBegin = Data.ReusePlan.Sources.begin() + Reused.SourceIdx;
+            for (auto Itr = SourcesBegin; Itr != SourcesBegin + Reused.SourceCount; ++Itr) {
+                auto& SourceInfo = Data.ArchiveChunkInfos[Itr->ChunkIdx];
+                (BeginChunkDataItr + SourceInfo.DataSector * Game::Header::GetSectorSize() + Itr->ChunkOffset).FastRead(ChunkData.get() + Itr->Offset, Itr->Size);
+            }
+        }
+        Data.BytesReadTotal.fetch_add((uint64_t)Chunk.WindowSize, std::memory_order::relaxed);
+
+        // The old data might not have been fully written if a previous update was interrupted
+        if (!Utils::SHA1Verify(ChunkData.get(), Chunk.WindowSize, Chunk.SHAHash)) {
+            Data.ExpectInstall(Chunk);
+            if (Reused.IsRelabel()) {
+                Data.WriteTotal.fetch_add(Chunk.WindowSize, std::memory_order::relaxed);
+            }
+            return InstallOne(Chunk, ChunkInfoData);
+        }
+
+        WriteChunkInfo(Chunk, ChunkInfoData);
+
+        if (!Reused.IsRelabel()) {
+            OnChunkUpdate(Chunk.Guid, ChunkState::WritingData);
+
+            WriteLimiter.Acquire(Chunk.WindowSize);
+            auto ChunkDataItr = BeginChunkDataItr + ChunkInfoData.DataSector * Game::Header::GetSectorSize();
+            ChunkDataItr.FastWrite(ChunkData.get(), Chunk.WindowSize);
+            Data.ArchiveChunkDatas.flush(ChunkDataItr, Chunk.WindowSize);
+
+            Data.BytesWriteTotal.fetch_add(Chunk.WindowSize, std::memory_order::relaxed);
+        }
+
+        OnChunkUpdate(Chunk.Guid, ChunkState::Completed);
+        return true;
     }
 
-    Web::Response<Web::Epic::BPS::ChunkData> DownloadInfo::GetChunk(const Web::Epic::BPS::ChunkInfo& Chunk) const
+    Web::Response<Web::Epic::BPS::ChunkData> DownloadInfo::GetChunk(const Web::Epic::BPS::ChunkInfo& Chunk)
     {
         auto& Data = GetStateData<StateInstalling>();
 
         Web::Response<Web::Epic::BPS::ChunkData> Resp;
-        for (int i = 0; i < 5; ++i) { // Max 5 retries
+        for (int i = 0; i < MaxChunkAttempts; ++i) {
+            if (i) {
+                Data.ChunkRetries.fetch_add(1, std::memory_order::relaxed);
+                // Back off so a struggling server isn't hit again right away
+                // Slept in steps so a cancel doesn't have to wait out the whole delay
+                auto Delay = ChunkRetryDelay * (1 << (i - 1));
+                for (std::chrono::milliseconds Slept(0); Slept < Delay && !IsCancelled(); Slept += CancelCheckInterval) {
+                    std::this_thread::sleep_for(CancelCheckInterval);
+                }
+            }
+
+            // FileSize is the compressed size, which is what's actually downloaded
+            NetworkLimiter.Acquire(Chunk.FileSize);
+
+            if (IsCancelled()) {
+                return Web::ErrorData::Status::Cancelled;
+            }
+
             Resp = Web::Epic::EpicClient().GetChunk(Data.CloudDir, Data.Manifest.ManifestMeta.FeatureLevel, Chunk);
             if (Resp.HasError()) {
                 continue;
@@ -465,12 +651,29 @@ namespace EGL3::Storage::Models {
             if (Resp->HasError()) {
                 continue;
             }
+
+            // The chunk is only checked against its own header, make sure it's the one the manifest wants
+            auto& Header = Resp->Header;
+            if (Header.Guid != Chunk.Guid || Header.DataSizeUncompressed != Chunk.WindowSize ||
+                !(Header.UsesSha1() ? memcmp(Header.SHAHash, Chunk.SHAHash, sizeof(Chunk.SHAHash)) == 0 : Utils::SHA1Verify(Resp->Data.get(), Chunk.WindowSize, Chunk.SHAHash))) {
+                EGL3_LOGF(LogLevel::Warning, "Chunk {:08X}{:08X}{:08X}{:08X} doesn't match the manifest", Chunk.Guid.A, Chunk.Guid.B, Chunk.Guid.C, Chunk.Guid.D);
+                Resp = Web::ErrorData::Status::Failure;
+                continue;
+            }
             break;
         }
 
         return Resp;
     }
 
+    bool DownloadInfo::IsCancelled()
+    {
+        auto& Data = GetStateData<StateInstalling>();
+
+        std::lock_guard Guard(Data.DataMutex);
+        return Data.Cancelled;
+    }
+
     Storage::Game::ChunkInfo& DownloadInfo::AllocateChunkInfo()
     {
         auto& Data = GetStateData<StateInstalling>();
@@ -480,16 +683,71 @@ namespace EGL3::Storage::Models {
         return Data.ArchiveChunkInfos.emplace_back();
     }
 
+    Storage::Game::ChunkInfo& DownloadInfo::AcquireChunkInfo(const Web::Epic::BPS::ChunkInfo& Chunk, std::unique_lock<std::mutex>& Lock)
+    {
+        auto& Data = GetStateData<StateInstalling>();
+
+        if (!Data.DeletedChunkIdxs.empty()) {
+            uint32_t ReplaceIdx = Pop(Data.DeletedChunkIdxs);
+            Lock.unlock();
+
+            auto& ChunkInfoData = Data.ArchiveChunkInfos[ReplaceIdx];
+
+            // Original chunk doesn't have enough space for the new chunk data
+            if (Chunk.WindowSize > ChunkInfoData.UncompressedSize) {
+                ChunkInfoData.DataSector = AllocateChunkData(Chunk.WindowSize);
+            }
+
+            Data.BytesReadTotal.fetch_add(sizeof(ChunkInfoData), std::memory_order::relaxed);
+
+            return ChunkInfoData;
+        }
+        else {
+            Lock.unlock();
+
+            auto& ChunkInfoData = AllocateChunkInfo();
+
+            ChunkInfoData.DataSector = AllocateChunkData(Chunk.WindowSize);
+
+            return ChunkInfoData;
+        }
+    }
+
+    void DownloadInfo::WriteChunkInfo(const Web::Epic::BPS::ChunkInfo& Chunk, Storage::Game::ChunkInfo& ChunkInfoData)
+    {
+        auto& Data = GetStateData<StateInstalling>();
+
+        OnChunkUpdate(Chunk.Guid, ChunkState::WritingMetadata);
+
+        ChunkInfoData.Guid = Chunk.Guid;
+        memcpy(ChunkInfoData.SHA, Chunk.SHAHash, 20);
+        ChunkInfoData.UncompressedSize = Chunk.WindowSize;
+        ChunkInfoData.CompressedSize = Chunk.WindowSize;
+        // ChunkInfoData.DataSector
+        ChunkInfoData.Hash = Chunk.Hash;
+        ChunkInfoData.DataGroup = Chunk.GroupNumber;
+
+        Data.BytesWriteTotal.fetch_add(sizeof(ChunkInfoData), std::memory_order::relaxed);
+    }
+
     uint32_t DownloadInfo::AllocateChunkData(uint32_t WindowSize)
     {
         auto& Data = GetStateData<StateInstalling>();
 
-        std::lock_guard Guard(Data.ChunkDataMutex);
+        auto Size = Utils::Align<Game::Header::GetSectorSize()>((uint64_t)WindowSize);
+        auto StartOffset = Data.ChunkDataCursor.fetch_add(Size, std::memory_order::relaxed);
 
-        auto StartOffset = Utils::Align<Game::Header::GetSectorSize()>(Data.ArchiveChunkDatas.size());
-        auto EndOffset = Utils::Align<Game::Header::GetSectorSize()>(StartOffset + WindowSize);
+        // Only sectors that were handed out count towards the size, so an interrupted install leaves the rest of the reservation free
+        // Another allocation past this one may have already grown it, then there's nothing to lock
+        auto EndOffset = StartOffset + Size;
+        if (Data.ChunkDataSize.load(std::memory_order::acquire) < EndOffset) {
+            std::lock_guard Guard(Data.ChunkDataMutex);
 
-        Data.ArchiveChunkDatas.resize(EndOffset);
+            if (Data.ChunkDataSize.load(std::memory_order::relaxed) < EndOffset) {
+                Data.ArchiveChunkDatas.resize(EndOffset);
+                Data.ChunkDataSize.store(EndOffset, std::memory_order::release);
+            }
+        }
 
         return StartOffset / Game::Header::GetSectorSize();
     }
@@ -501,14 +759,22 @@ namespace EGL3::Storage::Models {
         return Ret;
     }
 
-    void DownloadInfo::InitializeArchive(Game::GameId Id, const Web::Epic::BPS::ManifestMeta& Meta, const std::string& CloudDir, Game::ArchiveRef<Game::Header> Header, Game::ArchiveRef<Game::ManifestData> ManifestData)
+    void DownloadInfo::BeginArchiveUpdate(Game::GameId Id, const Web::Epic::BPS::ManifestMeta& Meta, Game::ArchiveRef<Game::Header> Header)
     {
+        uint64_t VersionNum;
+        std::string VersionHR;
+        Modules::Game::GameInfoModule::ParseGameVersion(Id, Meta.BuildVersion, VersionNum, VersionHR);
+
         Header->SetGameId(Id);
         Header->GetUpdateInfo().IsUpdating = true;
+        Header->GetUpdateInfo().TargetVersion = VersionNum;
         Header->GetUpdateInfo().NanosecondsElapsed = 0;
         Header->GetUpdateInfo().PiecesComplete = 0;
         Header->GetUpdateInfo().BytesDownloadTotal = 0;
+    }
 
+    void DownloadInfo::CommitArchiveUpdate(Game::GameId Id, const Web::Epic::BPS::ManifestMeta& Meta, const std::string& CloudDir, Game::ArchiveRef<Game::Header> Header, Game::ArchiveRef<Game::ManifestData> ManifestData)
+    {
         std::string GameName;
         EGL3_VERIFY(Modules::Game::GameInfoModule::GetGameName(Id, GameName), "Could not get game name");
 
@@ -520,12 +786,13 @@ namespace EGL3::Storage::Models {
         Header->SetVersionLong(Meta.BuildVersion);
         Header->SetVersionHR(VersionHR);
         Header->SetVersionNum(VersionNum);
-        Header->GetUpdateInfo().TargetVersion = VersionNum;
 
         ManifestData->SetAppID(Meta.AppId);
         ManifestData->SetLaunchExe(Meta.LaunchExe);
         ManifestData->SetLaunchCommand(Meta.LaunchCommand);
         ManifestData->SetAppName(Meta.AppName);
         ManifestData->SetCloudDir(CloudDir);
+
+        Header->GetUpdateInfo().IsUpdating = false;
     }
 }
\ No newline at end of file
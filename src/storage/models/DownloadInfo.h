@@ -2,6 +2,9 @@
 
 #include "../../utils/egl/ChunkProvider.h"
 #include "../../utils/Callback.h"
+#include "../../utils/Executor.h"
+#include "../../utils/GuidSet.h"
+#include "../../utils/RateLimiter.h"
 #include "../../utils/TaskPool.h"
 #include "../../storage/models/InstalledGame.h"
 #include "../../web/epic/bps/ChunkData.h"
@@ -9,16 +12,20 @@
 #include "../../web/Response.h"
 #include "../game/ArchiveList.h"
 #include "../game/GameId.h"
+#include "ArchiveChunkProvider.h"
+#include "ChunkReusePlan.h"
 #include "DownloadInfoStats.h"
+#include "InstallScheduler.h"
 
 #include <functional>
-#include <future>
 #include <mutex>
 #include <sigc++/sigc++.h>
+#include <thread>
 #include <variant>
 
 namespace EGL3::Storage::Models {
     class DownloadInfo {
+        // Upper bound, the pool is also capped by the executor's install lane limit
         constexpr static size_t WorkerCount = 32;
 
     public:
@@ -54,8 +61,11 @@ namespace EGL3::Storage::Models {
         struct StateInstalling {
             std::mutex DataMutex;
             bool Cancelled;
-            std::vector<std::reference_wrapper<const Web::Epic::BPS::ChunkInfo>> UpdatedChunks;
+            InstallScheduler Scheduler;
             std::vector<uint32_t> DeletedChunkIdxs;
+            ChunkReusePlan ReusePlan;
+            // Reused chunks that aren't written yet, the plan's source chunks are released once this hits 0
+            size_t ReusePending;
 
             std::string CloudDir;
             Web::Epic::BPS::Manifest Manifest;
@@ -65,21 +75,31 @@ namespace EGL3::Storage::Models {
             Utils::TaskPool Pool;
 
             Utils::EGL::ChunkProvider EGLProvider;
+            ArchiveChunkProvider ArchiveProvider;
 
             // For stats
             uint32_t PiecesTotal;
-            uint64_t DownloadTotal; // In the end, this is how much should be downloaded
+            // Expected totals, they only grow when something falls back to being downloaded
+            std::atomic<uint64_t> DownloadTotal; // In the end, this is how much should be downloaded
+            std::atomic<uint64_t> ReadTotal;
+            std::atomic<uint64_t> WriteTotal;
 
             std::atomic<uint32_t> PiecesComplete;
             std::atomic<uint64_t> BytesDownloadTotal;
             std::atomic<uint64_t> BytesReadTotal;
             std::atomic<uint64_t> BytesWriteTotal;
+            std::atomic<uint32_t> ChunkRetries;
 
             // Used to calculate rates
             uint64_t BytesDownloadTotalLast;
             uint64_t BytesReadTotalLast;
             uint64_t BytesWriteTotalLast;
 
+            // Chunk data is handed out from this byte offset, the runlist's size follows it
+            std::atomic<uint64_t> ChunkDataCursor;
+            // The runlist's size, only stored after the runlist has grown to it
+            std::atomic<uint64_t> ChunkDataSize;
+            // Taken to grow the runlist's size
             std::mutex ChunkDataMutex;
             std::mutex ChunkInfoMutex;
             Game::ArchiveList<Game::RunlistId::File> ArchiveFiles;
@@ -87,31 +107,59 @@ namespace EGL3::Storage::Models {
             Game::ArchiveList<Game::RunlistId::ChunkInfo> ArchiveChunkInfos;
             Game::ArchiveList<Game::RunlistId::ChunkData> ArchiveChunkDatas;
 
-            StateInstalling(std::string&& CloudDir, Web::Epic::BPS::Manifest&& Manifest, std::vector<std::reference_wrapper<const Web::Epic::BPS::FileManifest>>&& ManifestFiles, Game::Archive& Archive, std::vector<std::reference_wrapper<const Web::Epic::BPS::ChunkInfo>>&& UpdatedChunks, std::vector<uint32_t>&& DeletedChunkIdxs, Utils::EGL::ChunkProvider&& EGLProvider) :
+            StateInstalling(std::string&& CloudDir, Web::Epic::BPS::Manifest&& Manifest, std::vector<std::reference_wrapper<const Web::Epic::BPS::FileManifest>>&& ManifestFiles, Game::Archive& Archive, InstallScheduler&& Scheduler, std::vector<uint32_t>&& DeletedChunkIdxs, ChunkReusePlan&& ReusePlan, Utils::EGL::ChunkProvider&& EGLProvider, ArchiveChunkProvider&& ArchiveProvider) :
                 Cancelled(false),
+                Scheduler(std::move(Scheduler)),
+                DeletedChunkIdxs(std::move(DeletedChunkIdxs)),
+                ReusePlan(std::move(ReusePlan)),
+                ReusePending(this->ReusePlan.Chunks.size()),
                 CloudDir(std::move(CloudDir)),
                 Manifest(std::move(Manifest)),
                 ManifestFiles(std::move(ManifestFiles)),
                 Archive(Archive),
-                UpdatedChunks(std::move(UpdatedChunks)),
-                DeletedChunkIdxs(std::move(DeletedChunkIdxs)),
                 Pool(WorkerCount),
                 EGLProvider(std::move(EGLProvider)),
-                PiecesTotal(this->UpdatedChunks.size()),
-                DownloadTotal(std::accumulate(this->UpdatedChunks.begin(), this->UpdatedChunks.end(), 0ull, [](uint64_t Val, const auto& Chunk) { return Val + Chunk.get().FileSize; })),
+                ArchiveProvider(std::move(ArchiveProvider)),
+                PiecesTotal(this->Scheduler.size() + this->ReusePlan.Chunks.size()),
+                DownloadTotal(0),
+                ReadTotal(0),
+                WriteTotal(0),
                 PiecesComplete(0),
                 BytesDownloadTotal(0),
                 BytesReadTotal(0),
                 BytesWriteTotal(0),
+                ChunkRetries(0),
                 BytesDownloadTotalLast(0),
                 BytesReadTotalLast(0),
                 BytesWriteTotalLast(0),
+                ChunkDataCursor(0),
+                ChunkDataSize(0),
                 ArchiveFiles(Archive),
                 ArchiveChunkParts(Archive),
                 ArchiveChunkInfos(Archive),
                 ArchiveChunkDatas(Archive)
             {
+                for (auto& Chunk : this->Scheduler.GetQueue()) {
+                    ExpectInstall(Chunk);
+                    WriteTotal += Chunk.get().WindowSize;
+                }
+                for (auto& Reused : this->ReusePlan.Chunks) {
+                    ReadTotal += Reused.Chunk.get().WindowSize;
+                    if (!Reused.IsRelabel()) {
+                        WriteTotal += Reused.Chunk.get().WindowSize;
+                    }
+                }
+            }
 
+            // Chunks the providers probably have are expected to be read instead of downloaded
+            void ExpectInstall(const Web::Epic::BPS::ChunkInfo& Chunk)
+            {
+                if (ArchiveProvider.IsChunkAvailable(Chunk) || (EGLProvider.IsValid() && EGLProvider.IsChunkProbablyAvailable(Chunk.Guid))) {
+                    ReadTotal += Chunk.WindowSize;
+                }
+                else {
+                    DownloadTotal += Chunk.FileSize;
+                }
             }
         };
 
@@ -122,7 +170,8 @@ namespace EGL3::Storage::Models {
         using LatestManifestRequest = std::function<Web::Response<Web::Epic::BPS::Manifest>(Game::GameId Id, std::string& CloudDir)>;
         using CreateGameConfig = std::function<InstalledGame&()>;
 
-        DownloadInfo(Game::GameId Id, InstalledGame* GameConfig);
+        // The global limiters are shared by every install, the install's own limits are applied on top of them
+        DownloadInfo(Game::GameId Id, InstalledGame* GameConfig, Utils::RateLimiter* GlobalNetworkLimiter = nullptr, Utils::RateLimiter* GlobalWriteLimiter = nullptr);
 
         ~DownloadInfo();
 
@@ -152,6 +201,10 @@ namespace EGL3::Storage::Models {
 
         void CancelDownloadSetup();
 
+        // The user's other archives, chunks they already have are copied instead of downloaded
+        // Must be set before the download begins
+        void SetSharedArchives(std::vector<std::filesystem::path>&& ArchivePaths);
+
         void BeginDownload(const LatestManifestRequest& GetLatestManifest, const CreateGameConfig& CreateGameConfig);
 
         void SetDownloadRunning(bool Running = true);
@@ -160,7 +213,12 @@ namespace EGL3::Storage::Models {
 
         bool InstallOne();
 
-        void InstallOne(const Web::Epic::BPS::ChunkInfo& Chunk, Storage::Game::ChunkInfo& ChunkInfoData);
+        // Returns false if the install was cancelled before anything was written
+        bool InstallOne(const Web::Epic::BPS::ChunkInfo& Chunk, Storage::Game::ChunkInfo& ChunkInfoData);
+
+        // Rebuilds or relabels the chunk from data already in the archive, falls back to installing it normally if that fails
+        // Returns false if that fallback was cancelled
+        bool ReuseOne(const ChunkReusePlan::ReusedChunk& Reused, Storage::Game::ChunkInfo& ChunkInfoData);
 
         Utils::Callback<void(const DownloadInfoStats&)> OnStatsUpdate;
         Utils::Callback<void(const Utils::Guid&, ChunkState)> OnChunkUpdate;
@@ -168,20 +226,42 @@ namespace EGL3::Storage::Models {
         sigc::signal<void(DownloadInfoState)> OnStateUpdate;
 
     private:
-        Web::Response<Web::Epic::BPS::ChunkData> GetChunk(const Web::Epic::BPS::ChunkInfo& Chunk) const;
+        // Every attempt is charged to the network limiter, returns Cancelled if the install is cancelled between attempts
+        Web::Response<Web::Epic::BPS::ChunkData> GetChunk(const Web::Epic::BPS::ChunkInfo& Chunk);
+
+        bool IsCancelled();
+
+        // DataMutex must be held
+        void OnChunkInstalled(const Web::Epic::BPS::ChunkInfo& Chunk);
 
         Storage::Game::ChunkInfo& AllocateChunkInfo();
 
+        // Replaces a deleted chunk if there is one, otherwise allocates a new one. Lock is held on DataMutex and is released
+        Storage::Game::ChunkInfo& AcquireChunkInfo(const Web::Epic::BPS::ChunkInfo& Chunk, std::unique_lock<std::mutex>& Lock);
+
+        void WriteChunkInfo(const Web::Epic::BPS::ChunkInfo& Chunk, Storage::Game::ChunkInfo& ChunkInfoData);
+
         // Returns the data sector to use for the chunk data runlist
         uint32_t AllocateChunkData(uint32_t WindowSize);
 
-        static void InitializeArchive(Game::GameId Id, const Web::Epic::BPS::ManifestMeta& Meta, const std::string& CloudDir, Game::ArchiveRef<Game::Header> Header, Game::ArchiveRef<Game::ManifestData> ManifestData);
+        // Marks the archive as updating, the header keeps describing the installed version until the update is committed
+        static void BeginArchiveUpdate(Game::GameId Id, const Web::Epic::BPS::ManifestMeta& Meta, Game::ArchiveRef<Game::Header> Header);
+
+        // Only call once the archive's lists and data are flushed
+        static void CommitArchiveUpdate(Game::GameId Id, const Web::Epic::BPS::ManifestMeta& Meta, const std::string& CloudDir, Game::ArchiveRef<Game::Header> Header, Game::ArchiveRef<Game::ManifestData> ManifestData);
 
         Game::GameId Id;
         InstalledGame* GameConfig;
+        std::vector<std::filesystem::path> SharedArchivePaths;
+
+        // Nested under the module's shared limiters, so this install's waits can be cancelled on their own
+        // Declared before the state data, install tasks use these until the state is destroyed
+        Utils::RateLimiter NetworkLimiter;
+        Utils::RateLimiter WriteLimiter;
 
         DownloadInfoState CurrentState;
         std::variant<StateOptions, StateInitializing, StateInstalling, StateCancelled> StateData;
-        std::future<void> PrimaryTask;
+        // Not an executor task, it spends the whole install blocked on the pool and would hold a lane slot the entire time
+        std::thread PrimaryThread;
     };
 }
\ No newline at end of file
@@ -20,12 +20,25 @@ namespace EGL3::Storage::Models {
         uint64_t NanosecondCurrentTimestamp;
         uint32_t PiecesTotal;
         uint64_t DownloadTotal;
+        // Bytes expected to be read locally and written to the archive, these can grow if a local read falls through
+        uint64_t ReadTotal;
+        uint64_t WriteTotal;
 
         uint32_t PiecesComplete;
         uint64_t BytesDownloadTotal;
+        uint64_t BytesReadTotal;
+        uint64_t BytesWriteTotal;
         uint64_t BytesDownloadRate;
         uint64_t BytesReadRate;
         uint64_t BytesWriteRate;
+
+        // Files needed to start the game, see InstallScheduler
+        uint32_t LaunchFilesTotal;
+        uint32_t LaunchFilesComplete;
+
+        // Mapped archive pages in the working set, and written bytes not yet written back
+        uint64_t MappedResidentBytes;
+        uint64_t MappedDirtyBytes;
     };
 
     enum class ChunkState : uint8_t {
@@ -0,0 +1,102 @@
+#include "FileTableBuilder.h"
+
+#include "../../utils/Executor.h"
+
+#include <algorithm>
+
+namespace EGL3::Storage::Models {
+    using namespace Web::Epic::BPS;
+
+    // Shards smaller than this aren't worth a task
+    static constexpr uint64_t MinChunkPartsPerShard = 1 << 15;
+
+    FileTableBuilder::FileTableBuilder(Game::ArchiveList<Game::RunlistId::File>& Files, Game::ArchiveList<Game::RunlistId::ChunkPart>& ChunkParts, const Game::ArchiveList<Game::RunlistId::ChunkInfo>& ChunkInfos, const std::vector<std::reference_wrapper<const FileManifest>>& ManifestFiles) :
+        FilesWritten(0),
+        ChunkPartsWritten(0),
+        Files(Files),
+        ChunkParts(ChunkParts),
+        ManifestFiles(ManifestFiles)
+    {
+        ChunkLookup.reserve(ChunkInfos.size());
+        uint32_t ChunkIdx = 0;
+        for (auto& Chunk : ChunkInfos) {
+            ChunkLookup.emplace_back(Chunk.Guid, ChunkIdx++);
+        }
+        std::sort(ChunkLookup.begin(), ChunkLookup.end());
+
+        ChunkPartStartIdxs.reserve(ManifestFiles.size() + 1);
+        uint64_t TotalChunkParts = 0;
+        for (const FileManifest& File : ManifestFiles) {
+            ChunkPartStartIdxs.emplace_back(uint32_t(TotalChunkParts));
+            TotalChunkParts += File.ChunkParts.size();
+        }
+        ChunkPartStartIdxs.emplace_back(uint32_t(TotalChunkParts));
+
+        // Resizing isn't thread safe, the shards only touch entries that exist
+        Files.resize(ManifestFiles.size());
+        ChunkParts.resize(TotalChunkParts);
+
+        // Split by chunk parts since that's most of the work, a shard ends after the file that crosses its share
+        uint64_t ShardSize = std::max(TotalChunkParts / Utils::Executor::Get().GetWorkerCount() + 1, MinChunkPartsPerShard);
+
+        std::vector<Utils::Future<ShardResult>> Shards;
+        uint32_t FileBegin = 0;
+        while (FileBegin < ManifestFiles.size()) {
+            auto ShardEnd = std::upper_bound(ChunkPartStartIdxs.begin() + FileBegin + 1, ChunkPartStartIdxs.end() - 1, ChunkPartStartIdxs[FileBegin] + ShardSize);
+            uint32_t FileEnd = std::max<uint32_t>(ShardEnd - ChunkPartStartIdxs.begin(), FileBegin + 1);
+
+            Shards.emplace_back(Utils::Executor::Get().Submit(Utils::TaskLane::Install, [this, FileBegin, FileEnd]() {
+                return BuildShard(FileBegin, FileEnd);
+            }));
+            FileBegin = FileEnd;
+        }
+
+        for (auto& Shard : Shards) {
+            auto Result = Shard.Get();
+            FilesWritten += Result.FilesWritten;
+            ChunkPartsWritten += Result.ChunkPartsWritten;
+        }
+    }
+
+    FileTableBuilder::ShardResult FileTableBuilder::BuildShard(uint32_t FileBegin, uint32_t FileEnd) const
+    {
+        ShardResult Result{ 0, 0 };
+
+        auto FileItr = Files.begin() + FileBegin;
+        auto ChunkPartItr = ChunkParts.begin() + ChunkPartStartIdxs[FileBegin];
+        for (uint32_t i = FileBegin; i < FileEnd; ++i, ++FileItr) {
+            const FileManifest& File = ManifestFiles[i];
+
+            Game::File NewFile{};
+            strncpy_s(NewFile.Filename, File.Filename.c_str(), File.Filename.size());
+            memcpy(NewFile.SHA, File.FileHash, sizeof(NewFile.SHA));
+            NewFile.FileSize = File.FileSize;
+            NewFile.ChunkPartDataStartIdx = ChunkPartStartIdxs[i];
+            NewFile.ChunkPartDataSize = File.ChunkParts.size();
+
+            if (memcmp(&*FileItr, &NewFile, sizeof(NewFile)) != 0) {
+                *FileItr = NewFile;
+                ++Result.FilesWritten;
+            }
+
+            for (auto& ChunkPart : File.ChunkParts) {
+                auto LookupItr = std::lower_bound(ChunkLookup.begin(), ChunkLookup.end(), std::make_pair(ChunkPart.Guid, 0u));
+                EGL3_VERIFY(LookupItr != ChunkLookup.end() && LookupItr->first == ChunkPart.Guid, "Chunk part references a chunk that isn't in the archive");
+
+                Game::ChunkPart NewChunkPart{
+                    .ChunkIdx = LookupItr->second,
+                    .Offset = ChunkPart.Offset,
+                    .Size = ChunkPart.Size
+                };
+
+                if (memcmp(&*ChunkPartItr, &NewChunkPart, sizeof(NewChunkPart)) != 0) {
+                    *ChunkPartItr = NewChunkPart;
+                    ++Result.ChunkPartsWritten;
+                }
+                ++ChunkPartItr;
+            }
+        }
+
+        return Result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../../web/epic/bps/Manifest.h"
+#include "../game/ArchiveList.h"
+
+#include <functional>
+
+namespace EGL3::Storage::Models {
+    // Writes the manifest's file and chunk part lists into the archive once every chunk is in its chunk info list
+    // Entries are built in parallel shards and only the ones that differ from what's already there are written,
+    // so an update that keeps most files leaves most of the lists' pages untouched
+    class FileTableBuilder {
+    public:
+        FileTableBuilder(Game::ArchiveList<Game::RunlistId::File>& Files, Game::ArchiveList<Game::RunlistId::ChunkPart>& ChunkParts, const Game::ArchiveList<Game::RunlistId::ChunkInfo>& ChunkInfos, const std::vector<std::reference_wrapper<const Web::Epic::BPS::FileManifest>>& ManifestFiles);
+
+        // Entries that were different and had to be written
+        uint32_t FilesWritten;
+        uint64_t ChunkPartsWritten;
+
+    private:
+        struct ShardResult {
+            uint32_t FilesWritten;
+            uint64_t ChunkPartsWritten;
+        };
+
+        // Files with an index in [FileBegin, FileEnd)
+        ShardResult BuildShard(uint32_t FileBegin, uint32_t FileEnd) const;
+
+        Game::ArchiveList<Game::RunlistId::File>& Files;
+        Game::ArchiveList<Game::RunlistId::ChunkPart>& ChunkParts;
+        const std::vector<std::reference_wrapper<const Web::Epic::BPS::FileManifest>>& ManifestFiles;
+
+        // Index of each file's first chunk part
+        std::vector<uint32_t> ChunkPartStartIdxs;
+        // Sorted by guid, for looking up chunk indexes
+        std::vector<std::pair<Utils::Guid, uint32_t>> ChunkLookup;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "InstallScheduler.h"
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+namespace EGL3::Storage::Models {
+    using namespace Web::Epic::BPS;
+
+    enum class PriorityTier : uint8_t {
+        Priority,
+        Launch,
+        Untagged,
+        Tagged
+    };
+
+    // Lower is installed sooner, ties are broken by Order
+    static constexpr uint64_t GetPriority(PriorityTier Tier, uint32_t Order) {
+        return (uint64_t)Tier << 32 | Order;
+    }
+
+    InstallScheduler::InstallScheduler(const std::vector<std::reference_wrapper<const FileManifest>>& ManifestFiles, const std::vector<std::string>& PriorityFiles, const std::vector<std::string>& LaunchFiles, std::vector<ChunkRef>&& Chunks, const std::vector<Utils::Guid>& TrackedGuids) :
+        FileRemaining(ManifestFiles.size()),
+        IsLaunchFile(ManifestFiles.size()),
+        LaunchFileCount(0),
+        LaunchFilesRemaining(0)
+    {
+        std::vector<uint64_t> FilePriorities;
+        FilePriorities.reserve(ManifestFiles.size());
+        std::unordered_map<std::string_view, uint32_t> FileLookup;
+        FileLookup.reserve(ManifestFiles.size());
+        for (uint32_t i = 0; i < ManifestFiles.size(); ++i) {
+            const FileManifest& File = ManifestFiles[i];
+            FilePriorities.emplace_back(GetPriority(File.InstallTags.empty() ? PriorityTier::Untagged : PriorityTier::Tagged, i));
+            FileLookup.emplace(File.Filename, i);
+        }
+
+        auto Prioritize = [&](const std::vector<std::string>& Files, PriorityTier Tier) {
+            for (uint32_t i = 0; i < Files.size(); ++i) {
+                auto Itr = FileLookup.find(Files[i]);
+                if (Itr != FileLookup.end()) {
+                    FilePriorities[Itr->second] = std::min(FilePriorities[Itr->second], GetPriority(Tier, i));
+                    IsLaunchFile[Itr->second] = true;
+                }
+            }
+        };
+        Prioritize(PriorityFiles, PriorityTier::Priority);
+        Prioritize(LaunchFiles, PriorityTier::Launch);
+
+        PendingChunks.reserve(Chunks.size() + TrackedGuids.size());
+        for (const ChunkInfo& Chunk : Chunks) {
+            PendingChunks.emplace_back(PendingChunk{ .Guid = Chunk.Guid, .Installed = false, .FileIdx = 0, .FileCount = 0 });
+        }
+        for (auto& Guid : TrackedGuids) {
+            PendingChunks.emplace_back(PendingChunk{ .Guid = Guid, .Installed = false, .FileIdx = 0, .FileCount = 0 });
+        }
+        std::sort(PendingChunks.begin(), PendingChunks.end(), [](const PendingChunk& A, const PendingChunk& B) {
+            return A.Guid < B.Guid;
+        });
+        PendingChunks.erase(std::unique(PendingChunks.begin(), PendingChunks.end(), [](const PendingChunk& A, const PendingChunk& B) {
+            return A.Guid == B.Guid;
+        }), PendingChunks.end());
+
+        auto FindPending = [this](const Utils::Guid& Guid) {
+            return std::lower_bound(PendingChunks.begin(), PendingChunks.end(), Guid, [](const PendingChunk& Chunk, const Utils::Guid& Guid) {
+                return Chunk.Guid < Guid;
+            });
+        };
+
+        // Every (pending chunk, file) pair, a file that uses a chunk more than once only waits on it once
+        std::vector<std::pair<uint32_t, uint32_t>> Refs;
+        for (uint32_t i = 0; i < ManifestFiles.size(); ++i) {
+            const FileManifest& File = ManifestFiles[i];
+            for (auto& Part : File.ChunkParts) {
+                auto Itr = FindPending(Part.Guid);
+                if (Itr != PendingChunks.end() && Itr->Guid == Part.Guid) {
+                    Refs.emplace_back(uint32_t(Itr - PendingChunks.begin()), i);
+                }
+            }
+        }
+        std::sort(Refs.begin(), Refs.end());
+        Refs.erase(std::unique(Refs.begin(), Refs.end()), Refs.end());
+
+        std::vector<uint64_t> ChunkPriorities(PendingChunks.size(), UINT64_MAX);
+        ChunkFiles.reserve(Refs.size());
+        for (auto& [ChunkIdx, FileIdx] : Refs) {
+            auto& Chunk = PendingChunks[ChunkIdx];
+            if (Chunk.FileCount == 0) {
+                Chunk.FileIdx = ChunkFiles.size();
+            }
+            ChunkFiles.emplace_back(FileIdx);
+            ++Chunk.FileCount;
+
+            ++FileRemaining[FileIdx];
+            ChunkPriorities[ChunkIdx] = std::min(ChunkPriorities[ChunkIdx], FilePriorities[FileIdx]);
+        }
+
+        for (uint32_t i = 0; i < ManifestFiles.size(); ++i) {
+            if (IsLaunchFile[i]) {
+                ++LaunchFileCount;
+                if (FileRemaining[i]) {
+                    ++LaunchFilesRemaining;
+                }
+            }
+        }
+
+        // Stays in the original order when priorities are equal
+        std::vector<std::pair<uint64_t, uint32_t>> Order;
+        Order.reserve(Chunks.size());
+        for (uint32_t i = 0; i < Chunks.size(); ++i) {
+            Order.emplace_back(ChunkPriorities[FindPending(Chunks[i].get().Guid) - PendingChunks.begin()], i);
+        }
+        std::sort(Order.begin(), Order.end(), std::greater<>());
+
+        Queue.reserve(Chunks.size());
+        for (auto& [Priority, Idx] : Order) {
+            Queue.emplace_back(Chunks[Idx]);
+        }
+    }
+
+    bool InstallScheduler::empty() const
+    {
+        return Queue.empty();
+    }
+
+    size_t InstallScheduler::size() const
+    {
+        return Queue.size();
+    }
+
+    InstallScheduler::ChunkRef InstallScheduler::Pop()
+    {
+        auto Ret = Queue.back();
+        Queue.pop_back();
+        return Ret;
+    }
+
+    const std::vector<InstallScheduler::ChunkRef>& InstallScheduler::GetQueue() const
+    {
+        return Queue;
+    }
+
+    bool InstallScheduler::OnChunkInstalled(const Utils::Guid& Guid)
+    {
+        auto Itr = std::lower_bound(PendingChunks.begin(), PendingChunks.end(), Guid, [](const PendingChunk& Chunk, const Utils::Guid& Guid) {
+            return Chunk.Guid < Guid;
+        });
+        if (Itr == PendingChunks.end() || Itr->Guid != Guid || Itr->Installed) {
+            return false;
+        }
+        Itr->Installed = true;
+
+        bool BecamePlayable = false;
+        for (auto FileItr = ChunkFiles.begin() + Itr->FileIdx; FileItr != ChunkFiles.begin() + Itr->FileIdx + Itr->FileCount; ++FileItr) {
+            if (--FileRemaining[*FileItr] == 0 && IsLaunchFile[*FileItr] && --LaunchFilesRemaining == 0) {
+                BecamePlayable = true;
+            }
+        }
+        return BecamePlayable;
+    }
+
+    bool InstallScheduler::IsFileResident(size_t FileIdx) const
+    {
+        return FileRemaining[FileIdx] == 0;
+    }
+
+    uint32_t InstallScheduler::GetLaunchFileCount() const
+    {
+        return LaunchFileCount;
+    }
+
+    uint32_t InstallScheduler::GetResidentLaunchFileCount() const
+    {
+        return LaunchFileCount - LaunchFilesRemaining;
+    }
+
+    bool InstallScheduler::IsPlayable() const
+    {
+        return LaunchFilesRemaining == 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../../web/epic/bps/Manifest.h"
+
+#include <functional>
+
+namespace EGL3::Storage::Models {
+    // Orders chunk installs by the files that use them, so the game can be started before the whole install is done
+    // Files are installed in this order:
+    //   1. The priority files (the launch executable), in the order given
+    //   2. The archive's launch files (what the game opened first last time), in the order they were opened
+    //   3. Files without install tags
+    //   4. Everything else
+    // Not thread safe, DownloadInfo guards it with its data mutex
+    class InstallScheduler {
+    public:
+        using ChunkRef = std::reference_wrapper<const Web::Epic::BPS::ChunkInfo>;
+
+        // Chunks are the ones to schedule, TrackedGuids are chunks installed some other way that files still wait on
+        InstallScheduler(const std::vector<std::reference_wrapper<const Web::Epic::BPS::FileManifest>>& ManifestFiles, const std::vector<std::string>& PriorityFiles, const std::vector<std::string>& LaunchFiles, std::vector<ChunkRef>&& Chunks, const std::vector<Utils::Guid>& TrackedGuids);
+
+        bool empty() const;
+
+        size_t size() const;
+
+        // Highest priority chunk that's left
+        ChunkRef Pop();
+
+        // Chunks that haven't been popped yet, the next one is at the back
+        const std::vector<ChunkRef>& GetQueue() const;
+
+        // Returns true if this made every launch file resident
+        bool OnChunkInstalled(const Utils::Guid& Guid);
+
+        // Idx is the index in ManifestFiles
+        bool IsFileResident(size_t FileIdx) const;
+
+        uint32_t GetLaunchFileCount() const;
+
+        uint32_t GetResidentLaunchFileCount() const;
+
+        // All priority and launch files are resident
+        bool IsPlayable() const;
+
+    private:
+        // Sorted by priority, lowest first, so the next chunk is popped off the back
+        std::vector<ChunkRef> Queue;
+
+        struct PendingChunk {
+            Utils::Guid Guid;
+            bool Installed;
+            uint32_t FileIdx;
+            uint32_t FileCount;
+        };
+
+        // Sorted by guid, FileIdx/FileCount index into ChunkFiles
+        std::vector<PendingChunk> PendingChunks;
+        std::vector<uint32_t> ChunkFiles;
+
+        // Chunks each file is still waiting on
+        std::vector<uint32_t> FileRemaining;
+        std::vector<bool> IsLaunchFile;
+        uint32_t LaunchFileCount;
+        uint32_t LaunchFilesRemaining;
+    };
+}
\ No newline at end of file
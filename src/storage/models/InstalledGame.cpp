@@ -1,6 +1,7 @@
 #include "InstalledGame.h"
 
 #include "../../utils/Log.h"
+#include "ArchiveSnapshot.h"
 
 namespace EGL3::Storage::Models {
     Utils::Streams::Stream& operator>>(Utils::Streams::Stream& Stream, InstalledGame& Val)
@@ -114,6 +115,32 @@ namespace EGL3::Storage::Models {
         Data.emplace<std::monostate>();
     }
 
+    bool InstalledGame::HasPreviousVersion() const
+    {
+        return ArchiveSnapshot::Exists(Path);
+    }
+
+    bool InstalledGame::RevertToPreviousVersion()
+    {
+        // The service is reading from the lists that would be replaced
+        if (MountData.has_value()) {
+            return false;
+        }
+
+        // OpenArchive would recreate an archive that doesn't load, which is the last thing a revert should do
+        if (!IsArchiveOpen()) {
+            Storage::Game::Archive Archive(Path, Storage::Game::ArchiveMode::Load);
+            if (!Archive.IsValid()) {
+                return false;
+            }
+            Data.emplace<Storage::Game::Archive>(std::move(Archive));
+        }
+
+        bool Reverted = ArchiveSnapshot::Revert(std::get<Storage::Game::Archive>(Data));
+        CloseArchive();
+        return Reverted;
+    }
+
     bool InstalledGame::IsMounted() const
     {
         return MountData->IsMounted();
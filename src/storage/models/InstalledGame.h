@@ -11,6 +11,7 @@ namespace EGL3::Storage::Models {
         AutoUpdate          = 0x0001,
         SelectedIds         = 0x0002,
         DefaultSelectedIds  = 0x0004,
+        KeepPreviousVersion = 0x0008,
         CreateShortcut      = 0x0100,
     };
 
@@ -51,6 +52,11 @@ namespace EGL3::Storage::Models {
 
         void CloseArchive();
 
+        // A snapshot of the version before the last update was kept, see ArchiveSnapshot
+        bool HasPreviousVersion() const;
+
+        bool RevertToPreviousVersion();
+
         bool IsMounted() const;
 
         bool Mount(Service::Pipe::Client& Client);
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace EGL3::Utils {
+    // Chase-Lev work stealing deque, following "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013)
+    // Only the owning thread may Push/Pop (LIFO end), any thread may Steal (FIFO end)
+    template<class ItemT>
+    class ChaseLevDeque {
+        static_assert(std::is_trivially_copyable_v<ItemT>, "Deque items are copied racily by stealers and must be trivially copyable");
+
+        class Buffer {
+        public:
+            Buffer(int64_t Capacity) :
+                Capacity(Capacity),
+                Items(std::make_unique<std::atomic<ItemT>[]>(Capacity))
+            {
+
+            }
+
+            int64_t GetCapacity() const {
+                return Capacity;
+            }
+
+            ItemT Get(int64_t Idx) const {
+                return Items[Idx & (Capacity - 1)].load(std::memory_order::relaxed);
+            }
+
+            void Put(int64_t Idx, ItemT Item) {
+                Items[Idx & (Capacity - 1)].store(Item, std::memory_order::relaxed);
+            }
+
+        private:
+            int64_t Capacity;
+            std::unique_ptr<std::atomic<ItemT>[]> Items;
+        };
+
+    public:
+        ChaseLevDeque(int64_t InitialCapacity = 256) :
+            Top(0),
+            Bottom(0)
+        {
+            Buffers.emplace_back(std::make_unique<Buffer>(InitialCapacity));
+            CurrentBuffer.store(Buffers.back().get(), std::memory_order::relaxed);
+        }
+
+        ChaseLevDeque(const ChaseLevDeque&) = delete;
+        ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+        // Owner only
+        void Push(ItemT Item) {
+            int64_t B = Bottom.load(std::memory_order::relaxed);
+            int64_t T = Top.load(std::memory_order::acquire);
+            Buffer* Buf = CurrentBuffer.load(std::memory_order::relaxed);
+            if (B - T > Buf->GetCapacity() - 1) {
+                Buf = Grow(Buf, B, T);
+            }
+            Buf->Put(B, Item);
+            std::atomic_thread_fence(std::memory_order::release);
+            Bottom.store(B + 1, std::memory_order::relaxed);
+        }
+
+        // Owner only
+        bool Pop(ItemT& Item) {
+            int64_t B = Bottom.load(std::memory_order::relaxed) - 1;
+            Buffer* Buf = CurrentBuffer.load(std::memory_order::relaxed);
+            Bottom.store(B, std::memory_order::relaxed);
+            std::atomic_thread_fence(std::memory_order::seq_cst);
+            int64_t T = Top.load(std::memory_order::relaxed);
+
+            if (T > B) {
+                // Empty
+                Bottom.store(B + 1, std::memory_order::relaxed);
+                return false;
+            }
+
+            Item = Buf->Get(B);
+            if (T != B) {
+                return true;
+            }
+
+            // Last item, race against stealers for it
+            bool Won = Top.compare_exchange_strong(T, T + 1, std::memory_order::seq_cst, std::memory_order::relaxed);
+            Bottom.store(B + 1, std::memory_order::relaxed);
+            return Won;
+        }
+
+        // Any thread, can spuriously fail if another thief won the item
+        bool Steal(ItemT& Item) {
+            int64_t T = Top.load(std::memory_order::acquire);
+            std::atomic_thread_fence(std::memory_order::seq_cst);
+            int64_t B = Bottom.load(std::memory_order::acquire);
+
+            if (T >= B) {
+                return false;
+            }
+
+            ItemT Ret = CurrentBuffer.load(std::memory_order::acquire)->Get(T);
+            if (!Top.compare_exchange_strong(T, T + 1, std::memory_order::seq_cst, std::memory_order::relaxed)) {
+                return false;
+            }
+            Item = Ret;
+            return true;
+        }
+
+        bool IsEmpty() const {
+            return Bottom.load(std::memory_order::relaxed) <= Top.load(std::memory_order::relaxed);
+        }
+
+    private:
+        Buffer* Grow(Buffer* Old, int64_t B, int64_t T) {
+            auto New = std::make_unique<Buffer>(Old->GetCapacity() * 2);
+            for (int64_t i = T; i < B; ++i) {
+                New->Put(i, Old->Get(i));
+            }
+
+            // Thieves may still be reading from the old buffer, so it's kept alive until the deque is destroyed
+            Buffers.emplace_back(std::move(New));
+            CurrentBuffer.store(Buffers.back().get(), std::memory_order::release);
+            return Buffers.back().get();
+        }
+
+        alignas(64) std::atomic<int64_t> Top;
+        alignas(64) std::atomic<int64_t> Bottom;
+        std::atomic<Buffer*> CurrentBuffer;
+        std::vector<std::unique_ptr<Buffer>> Buffers;
+    };
+}
\ No newline at end of file
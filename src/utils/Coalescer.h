@@ -0,0 +1,56 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace EGL3::Utils {
+    // Keeps only the latest value pushed for each key until the queue is drained.
+    // Drained values are given in the order their keys were first pushed.
+    template<class KeyT, class ValueT, class Hash = std::hash<KeyT>>
+    class Coalescer {
+    public:
+        // Returns true if nothing was pending beforehand, meaning a drain should be scheduled
+        template<class K, class V>
+        bool Push(K&& Key, V&& Value) {
+            std::lock_guard Guard(Mutex);
+
+            bool WasEmpty = Items.empty();
+            auto Itr = Indices.find(Key);
+            if (Itr != Indices.end()) {
+                Items[Itr->second].second = std::forward<V>(Value);
+            }
+            else {
+                Indices.emplace(Key, Items.size());
+                Items.emplace_back(std::forward<K>(Key), std::forward<V>(Value));
+            }
+            return WasEmpty;
+        }
+
+        // Func is called without the lock held, so it's allowed to push more values
+        template<class FuncT>
+        size_t Drain(FuncT&& Func) {
+            std::vector<std::pair<KeyT, ValueT>> Drained;
+            {
+                std::lock_guard Guard(Mutex);
+                Drained.swap(Items);
+                Indices.clear();
+            }
+
+            for (auto& Item : Drained) {
+                Func(Item.first, Item.second);
+            }
+            return Drained.size();
+        }
+
+        size_t GetPendingCount() const {
+            std::lock_guard Guard(Mutex);
+            return Items.size();
+        }
+
+    private:
+        mutable std::mutex Mutex;
+        std::unordered_map<KeyT, size_t, Hash> Indices;
+        std::vector<std::pair<KeyT, ValueT>> Items;
+    };
+}
\ No newline at end of file
@@ -17,6 +17,9 @@ namespace EGL3::Utils {
 
     template<>
     struct Compressor<CompressionMethod::Zlib> {
+        // Deflate can't shrink data further than this, anything claiming more is corrupt
+        static constexpr uint64_t MaxRatio = 1032;
+
         static bool Decompress(char* Dst, size_t DstSize, const char* Src, size_t SrcSize);
     };
 }
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "Coalescer.h"
+
+#include <chrono>
 #include <deque>
 #include <mutex>
 
 #include <glibmm/dispatcher.h>
+#include <glibmm/main.h>
 
 namespace EGL3::Utils {
     template<typename... ArgsT>
@@ -83,4 +87,51 @@ namespace EGL3::Utils {
         std::mutex Mutex;
         std::deque<std::tuple<ArgsT...>> ArgsQueue;
     };
+
+    // Only the latest data emitted for each key is dispatched. After the first emit,
+    // anything else emitted within the window is batched into the same dispatch.
+    template<class KeyT, class ValueT>
+    struct DataCoalescingDispatcher {
+    public:
+        DataCoalescingDispatcher(std::chrono::milliseconds Window = std::chrono::milliseconds(0)) :
+            Window(Window)
+        {
+
+        }
+
+        ~DataCoalescingDispatcher()
+        {
+            WindowConnection.disconnect();
+        }
+
+        template<class FuncT>
+        sigc::connection connect(FuncT&& Func)
+        {
+            return Dispatcher.connect([this, Func]() {
+                if (Window.count() == 0) {
+                    Queue.Drain(Func);
+                    return;
+                }
+
+                WindowConnection = Glib::signal_timeout().connect([this, Func]() {
+                    Queue.Drain(Func);
+                    return false;
+                }, Window.count());
+            });
+        }
+
+        template<class K, class V>
+        void emit(K&& Key, V&& Value)
+        {
+            if (Queue.Push(std::forward<K>(Key), std::forward<V>(Value))) {
+                Dispatcher.emit();
+            }
+        }
+
+    private:
+        Glib::Dispatcher Dispatcher;
+        sigc::connection WindowConnection;
+        std::chrono::milliseconds Window;
+        Coalescer<KeyT, ValueT> Queue;
+    };
 }
\ No newline at end of file
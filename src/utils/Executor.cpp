@@ -0,0 +1,275 @@
+#include "Executor.h"
+
+#include <algorithm>
+
+namespace EGL3::Utils {
+    // Almost everything submitted here blocks on http or disk io, so there are more workers than cores
+    static size_t GetDefaultWorkerCount() {
+        return std::clamp<size_t>(std::thread::hardware_concurrency() * 2, 16, 64);
+    }
+
+    static thread_local Executor* CurrentExecutor = nullptr;
+    static thread_local size_t CurrentWorkerIdx = 0;
+    // Lane of the task the worker is running, LaneCount if it isn't running one
+    static thread_local size_t CurrentLane = (size_t)TaskLane::Count;
+
+    void Detail::FutureStateBase::Wait() const {
+        if (GetStatus() != FutureStatus::Pending) {
+            return;
+        }
+
+        // Workers help run other tasks instead of blocking, otherwise enough nested waits could starve the pool
+        if (CurrentExecutor) {
+            while (GetStatus() == FutureStatus::Pending) {
+                if (!CurrentExecutor->TryRunOne()) {
+                    break;
+                }
+            }
+        }
+
+        while (GetStatus() == FutureStatus::Pending) {
+            Status.wait(FutureStatus::Pending, std::memory_order::acquire);
+        }
+    }
+
+    Executor::Executor(size_t WorkerCount) :
+        NonInteractiveLimit(std::max<size_t>(WorkerCount, 2) - 1),
+        NonInteractiveRunning(0),
+        Stopping(false),
+        WakeEpoch(0),
+        SleepingCount(0)
+    {
+        WorkerCount = std::max<size_t>(WorkerCount, 2);
+
+        LaneLimits[(size_t)TaskLane::Interactive] = WorkerCount;
+        LaneLimits[(size_t)TaskLane::Install] = NonInteractiveLimit;
+        LaneLimits[(size_t)TaskLane::Background] = std::max<size_t>(NonInteractiveLimit / 2, 1);
+        for (auto& Running : LaneRunning) {
+            Running.store(0, std::memory_order::relaxed);
+        }
+
+        // All worker data has to exist before any worker starts stealing from the others
+        Workers.reserve(WorkerCount);
+        for (size_t i = 0; i < WorkerCount; ++i) {
+            Workers.emplace_back(std::make_unique<WorkerData>());
+        }
+        for (size_t i = 0; i < WorkerCount; ++i) {
+            Workers[i]->Thread = std::thread(&Executor::Worker, this, i);
+        }
+    }
+
+    Executor::~Executor()
+    {
+        // Workers drain everything that's queued before exiting
+        Stopping.store(true);
+        Wake(true);
+
+        for (auto& Worker : Workers) {
+            Worker->Thread.join();
+        }
+    }
+
+    Executor& Executor::Get()
+    {
+        static Executor Instance(GetDefaultWorkerCount());
+        return Instance;
+    }
+
+    size_t Executor::GetWorkerCount() const
+    {
+        return Workers.size();
+    }
+
+    size_t Executor::GetLaneLimit(TaskLane Lane) const
+    {
+        return LaneLimits[(size_t)Lane];
+    }
+
+    bool Executor::IsWorkerThread() const
+    {
+        return CurrentExecutor == this;
+    }
+
+    bool Executor::TryRunOne()
+    {
+        if (!IsWorkerThread()) {
+            return false;
+        }
+        // Only tasks at least as important as the waiting one are helped with, a lower lane task
+        // (like the install loop) could block for far longer than what's being waited on
+        size_t MaxLane = std::min<size_t>(CurrentLane, LaneCount - 1);
+        return TryRunOne(Workers[CurrentWorkerIdx].get(), CurrentWorkerIdx + 1, MaxLane);
+    }
+
+    void Executor::Push(TaskLane Lane, Detail::TaskBase* Task)
+    {
+        // Nothing will pick it up anymore, run it here instead of losing it
+        if (Stopping.load(std::memory_order::relaxed)) {
+            Task->Run();
+            delete Task;
+            return;
+        }
+
+        if (IsWorkerThread()) {
+            Workers[CurrentWorkerIdx]->Queues[(size_t)Lane].Push(Task);
+        }
+        else {
+            auto& Queue = Injected[(size_t)Lane];
+            std::lock_guard Guard(Queue.Mutex);
+            Queue.Tasks.emplace_back(Task);
+        }
+
+        Wake();
+    }
+
+    bool Executor::TryAcquireLane(size_t Lane)
+    {
+        auto& Running = LaneRunning[Lane];
+        size_t Count = Running.load(std::memory_order::relaxed);
+        do {
+            if (Count >= LaneLimits[Lane]) {
+                return false;
+            }
+        } while (!Running.compare_exchange_weak(Count, Count + 1, std::memory_order::acquire, std::memory_order::relaxed));
+
+        if (Lane == (size_t)TaskLane::Interactive) {
+            return true;
+        }
+
+        size_t Total = NonInteractiveRunning.load(std::memory_order::relaxed);
+        do {
+            if (Total >= NonInteractiveLimit) {
+                Running.fetch_sub(1, std::memory_order::release);
+                return false;
+            }
+        } while (!NonInteractiveRunning.compare_exchange_weak(Total, Total + 1, std::memory_order::acquire, std::memory_order::relaxed));
+
+        return true;
+    }
+
+    void Executor::ReleaseLane(size_t Lane)
+    {
+        if (Lane != (size_t)TaskLane::Interactive) {
+            NonInteractiveRunning.fetch_sub(1, std::memory_order::release);
+        }
+        LaneRunning[Lane].fetch_sub(1, std::memory_order::release);
+    }
+
+    Detail::TaskBase* Executor::TryTake(size_t Lane, WorkerData* Self, size_t StartIdx)
+    {
+        Detail::TaskBase* Task;
+
+        if (Self && Self->Queues[Lane].Pop(Task)) {
+            return Task;
+        }
+
+        {
+            auto& Queue = Injected[Lane];
+            std::lock_guard Guard(Queue.Mutex);
+            if (!Queue.Tasks.empty()) {
+                Task = Queue.Tasks.front();
+                Queue.Tasks.pop_front();
+                return Task;
+            }
+        }
+
+        for (size_t i = 0; i < Workers.size(); ++i) {
+            auto& Victim = Workers[(StartIdx + i) % Workers.size()];
+            if (Victim.get() != Self && Victim->Queues[Lane].Steal(Task)) {
+                return Task;
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool Executor::TryRunOne(WorkerData* Self, size_t StartIdx, size_t MaxLane)
+    {
+        for (size_t Lane = 0; Lane <= MaxLane; ++Lane) {
+            if (!TryAcquireLane(Lane)) {
+                continue;
+            }
+
+            auto Task = TryTake(Lane, Self, StartIdx);
+            if (!Task) {
+                ReleaseLane(Lane);
+                continue;
+            }
+
+            size_t OuterLane = CurrentLane;
+            CurrentLane = Lane;
+            Task->Run();
+            delete Task;
+            CurrentLane = OuterLane;
+
+            ReleaseLane(Lane);
+            // A capped lane may have something runnable now
+            if (Lane != (size_t)TaskLane::Interactive) {
+                Wake();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void Executor::Wake(bool All)
+    {
+        WakeEpoch.fetch_add(1);
+        if (SleepingCount.load() == 0) {
+            return;
+        }
+
+        {
+            // Sleepers check the epoch under this lock, so taking it orders the bump before their wait
+            std::lock_guard Guard(SleepMutex);
+        }
+        if (All) {
+            SleepCV.notify_all();
+        }
+        else {
+            SleepCV.notify_one();
+        }
+    }
+
+    void Executor::Worker(size_t Idx)
+    {
+        CurrentExecutor = this;
+        CurrentWorkerIdx = Idx;
+
+        auto Self = Workers[Idx].get();
+        // Spread out where each worker starts stealing from
+        size_t StartIdx = Idx + 1;
+
+        while (true) {
+            uint64_t SeenEpoch = WakeEpoch.load();
+
+            if (TryRunOne(Self, StartIdx++, LaneCount - 1)) {
+                continue;
+            }
+
+            if (Stopping.load()) {
+                // Steals can spuriously fail, so only exit after a scan where nothing was queued anywhere
+                bool Empty = std::all_of(Workers.begin(), Workers.end(), [](const auto& Worker) {
+                    return std::all_of(Worker->Queues.begin(), Worker->Queues.end(), [](const auto& Queue) { return Queue.IsEmpty(); });
+                }) && std::all_of(Injected.begin(), Injected.end(), [](auto& Queue) {
+                    std::lock_guard Guard(Queue.Mutex);
+                    return Queue.Tasks.empty();
+                });
+                if (Empty) {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock Lock(SleepMutex);
+            SleepingCount.fetch_add(1);
+            SleepCV.wait(Lock, [this, SeenEpoch]() {
+                return Stopping.load() || WakeEpoch.load() != SeenEpoch;
+            });
+            SleepingCount.fetch_sub(1);
+        }
+
+        CurrentExecutor = nullptr;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,498 @@
+#pragma once
+
+#include "ChaseLevDeque.h"
+#include "Log.h"
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <variant>
+
+namespace EGL3::Utils {
+    // Lanes are picked in order, so a lane is only serviced once all lanes above it have nothing runnable
+    enum class TaskLane : uint8_t {
+        Interactive,    // Work the user is waiting on (images, friend actions)
+        Install,        // Chunk downloads and writes
+        Background,     // Long running or low priority jobs
+
+        Count
+    };
+
+    class CancelToken {
+    public:
+        CancelToken(const std::atomic<bool>& Flag) :
+            Flag(Flag)
+        {
+
+        }
+
+        bool IsCancelled() const {
+            return Flag.load(std::memory_order::relaxed);
+        }
+
+    private:
+        const std::atomic<bool>& Flag;
+    };
+
+    namespace Detail {
+        enum class FutureStatus : uint8_t {
+            Pending,
+            Ready,
+            Cancelled
+        };
+
+        class FutureStateBase {
+        public:
+            FutureStateBase() :
+                Status(FutureStatus::Pending),
+                CancelRequested(false)
+            {
+
+            }
+
+            FutureStatus GetStatus() const {
+                return Status.load(std::memory_order::acquire);
+            }
+
+            void Wait() const;
+
+            void RequestCancel() {
+                CancelRequested.store(true, std::memory_order::relaxed);
+            }
+
+            bool IsCancelRequested() const {
+                return CancelRequested.load(std::memory_order::relaxed);
+            }
+
+            CancelToken GetCancelToken() const {
+                return CancelToken(CancelRequested);
+            }
+
+            void SetException(std::exception_ptr NewException) {
+                Exception = NewException;
+            }
+
+            void RethrowIfException() const {
+                if (Exception) {
+                    std::rethrow_exception(Exception);
+                }
+            }
+
+            // Called at most once, after the value/exception is set
+            void Finish(FutureStatus NewStatus) {
+                std::vector<std::function<void()>> Continuations;
+                {
+                    std::lock_guard Guard(Mutex);
+                    Status.store(NewStatus, std::memory_order::release);
+                    Status.notify_all();
+
+                    // Ran under the lock so ClearOnReady can guarantee it won't be called afterwards
+                    if (OnReady) {
+                        OnReady();
+                        OnReady = nullptr;
+                    }
+                    Continuations.swap(this->Continuations);
+                }
+
+                for (auto& Continuation : Continuations) {
+                    Continuation();
+                }
+            }
+
+            void AddContinuation(std::function<void()>&& Continuation) {
+                {
+                    std::lock_guard Guard(Mutex);
+                    if (GetStatus() == FutureStatus::Pending) {
+                        Continuations.emplace_back(std::move(Continuation));
+                        return;
+                    }
+                }
+                Continuation();
+            }
+
+            void SetOnReady(std::function<void()>&& Callback) {
+                std::lock_guard Guard(Mutex);
+                if (GetStatus() == FutureStatus::Pending) {
+                    OnReady = std::move(Callback);
+                }
+                else {
+                    Callback();
+                }
+            }
+
+            void ClearOnReady() {
+                std::lock_guard Guard(Mutex);
+                OnReady = nullptr;
+            }
+
+        private:
+            std::atomic<FutureStatus> Status;
+            std::atomic<bool> CancelRequested;
+            std::exception_ptr Exception;
+
+            std::mutex Mutex;
+            std::function<void()> OnReady;
+            std::vector<std::function<void()>> Continuations;
+        };
+
+        template<class T>
+        class FutureState : public FutureStateBase {
+        public:
+            using StorageT = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+            template<class... ArgsT>
+            void SetValue(ArgsT&&... Args) {
+                Value.emplace(std::forward<ArgsT>(Args)...);
+            }
+
+            const StorageT& GetValue() const {
+                return *Value;
+            }
+
+        private:
+            std::optional<StorageT> Value;
+        };
+
+        // Runs Func and finishes State with its result or exception
+        template<class T, class FuncT, class... ArgsT>
+        void FulfillState(FutureState<T>& State, FuncT& Func, ArgsT&&... Args) {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    std::invoke(Func, std::forward<ArgsT>(Args)...);
+                    State.SetValue();
+                }
+                else {
+                    State.SetValue(std::invoke(Func, std::forward<ArgsT>(Args)...));
+                }
+            }
+            catch (...) {
+                State.SetException(std::current_exception());
+            }
+            State.Finish(FutureStatus::Ready);
+        }
+
+        class TaskBase {
+        public:
+            virtual ~TaskBase() = default;
+
+            virtual void Run() = 0;
+        };
+
+        template<class T, class FuncT>
+        class FunctorTask : public TaskBase {
+        public:
+            FunctorTask(FuncT&& Func, const std::shared_ptr<FutureState<T>>& State) :
+                Func(std::move(Func)),
+                State(State)
+            {
+
+            }
+
+            void Run() override {
+                if (State->IsCancelRequested()) {
+                    State->Finish(FutureStatus::Cancelled);
+                    return;
+                }
+
+                if constexpr (std::is_invocable_v<FuncT&, const CancelToken&>) {
+                    FulfillState(*State, Func, State->GetCancelToken());
+                }
+                else {
+                    FulfillState(*State, Func);
+                }
+            }
+
+        private:
+            FuncT Func;
+            std::shared_ptr<FutureState<T>> State;
+        };
+
+        template<class T, class FuncT>
+        struct ContinuationResult {
+            using Type = std::invoke_result_t<FuncT&, const T&>;
+        };
+
+        template<class FuncT>
+        struct ContinuationResult<void, FuncT> {
+            using Type = std::invoke_result_t<FuncT&>;
+        };
+
+        template<class FuncT, class Enable = void>
+        struct TaskResult {
+            using Type = std::invoke_result_t<FuncT&>;
+        };
+
+        template<class FuncT>
+        struct TaskResult<FuncT, std::enable_if_t<std::is_invocable_v<FuncT&, const CancelToken&>>> {
+            using Type = std::invoke_result_t<FuncT&, const CancelToken&>;
+        };
+
+        template<class T, class FuncT>
+        auto MakeContinuation(const std::shared_ptr<FutureState<T>>& Parent, FuncT&& Func);
+    }
+
+    template<class T>
+    class SharedFuture;
+
+    // Move-only handle to the result of a task, dropping it doesn't cancel or wait on the task
+    template<class T>
+    class Future {
+    public:
+        Future() = default;
+
+        Future(std::shared_ptr<Detail::FutureState<T>>&& State) :
+            State(std::move(State))
+        {
+
+        }
+
+        Future(Future&&) = default;
+
+        Future& operator=(Future&& Other) {
+            if (this != &Other) {
+                Reset();
+                State = std::move(Other.State);
+            }
+            return *this;
+        }
+
+        Future(const Future&) = delete;
+        Future& operator=(const Future&) = delete;
+
+        ~Future() {
+            Reset();
+        }
+
+        bool IsValid() const {
+            return (bool)State;
+        }
+
+        bool IsReady() const {
+            return State->GetStatus() != Detail::FutureStatus::Pending;
+        }
+
+        bool IsCancelled() const {
+            return State->GetStatus() == Detail::FutureStatus::Cancelled;
+        }
+
+        void Wait() const {
+            State->Wait();
+        }
+
+        // Waits if needed, the task must not have been cancelled before it started
+        decltype(auto) Get() const {
+            State->Wait();
+            EGL3_VERIFY(!IsCancelled(), "Getting the result of a cancelled task");
+            State->RethrowIfException();
+            if constexpr (!std::is_void_v<T>) {
+                return State->GetValue();
+            }
+        }
+
+        // Requests cancellation, the task is skipped if it hasn't started, otherwise it can check its CancelToken
+        void Cancel() const {
+            State->RequestCancel();
+        }
+
+        // Called once the task finishes, on the thread that finished it (or immediately if it's already finished)
+        // Guaranteed to not be called after this future is destroyed or reassigned
+        void SetOnReady(std::function<void()>&& Callback) const {
+            State->SetOnReady(std::move(Callback));
+        }
+
+        // Func(const T&) is ran on the thread that finishes this task, so it should be cheap
+        template<class FuncT>
+        auto Then(FuncT&& Func) const {
+            return Detail::MakeContinuation(State, std::forward<FuncT>(Func));
+        }
+
+        SharedFuture<T> Share() {
+            return SharedFuture<T>(std::move(State));
+        }
+
+    private:
+        void Reset() {
+            if (State) {
+                State->ClearOnReady();
+                State.reset();
+            }
+        }
+
+        std::shared_ptr<Detail::FutureState<T>> State;
+    };
+
+    // Copyable handle to the result of a task
+    template<class T>
+    class SharedFuture {
+    public:
+        SharedFuture() = default;
+
+        SharedFuture(std::shared_ptr<Detail::FutureState<T>>&& State) :
+            State(std::move(State))
+        {
+
+        }
+
+        bool IsValid() const {
+            return (bool)State;
+        }
+
+        bool IsReady() const {
+            return State->GetStatus() != Detail::FutureStatus::Pending;
+        }
+
+        bool IsCancelled() const {
+            return State->GetStatus() == Detail::FutureStatus::Cancelled;
+        }
+
+        void Wait() const {
+            State->Wait();
+        }
+
+        decltype(auto) Get() const {
+            State->Wait();
+            EGL3_VERIFY(!IsCancelled(), "Getting the result of a cancelled task");
+            State->RethrowIfException();
+            if constexpr (!std::is_void_v<T>) {
+                return State->GetValue();
+            }
+        }
+
+        void Cancel() const {
+            State->RequestCancel();
+        }
+
+        template<class FuncT>
+        auto Then(FuncT&& Func) const {
+            return Detail::MakeContinuation(State, std::forward<FuncT>(Func));
+        }
+
+    private:
+        std::shared_ptr<Detail::FutureState<T>> State;
+    };
+
+    namespace Detail {
+        template<class T, class FuncT>
+        auto MakeContinuation(const std::shared_ptr<FutureState<T>>& Parent, FuncT&& Func) {
+            using ResultT = typename ContinuationResult<T, std::decay_t<FuncT>>::Type;
+
+            auto Child = std::make_shared<FutureState<ResultT>>();
+            // The child is only held weakly, if every handle to it is dropped there's nothing to run
+            Parent->AddContinuation([Parent = Parent.get(), WeakChild = std::weak_ptr<FutureState<ResultT>>(Child), Func = std::forward<FuncT>(Func)]() mutable {
+                auto Child = WeakChild.lock();
+                if (!Child) {
+                    return;
+                }
+
+                if (Parent->GetStatus() == FutureStatus::Cancelled) {
+                    Child->Finish(FutureStatus::Cancelled);
+                    return;
+                }
+
+                try {
+                    Parent->RethrowIfException();
+                }
+                catch (...) {
+                    Child->SetException(std::current_exception());
+                    Child->Finish(FutureStatus::Ready);
+                    return;
+                }
+
+                if constexpr (std::is_void_v<T>) {
+                    FulfillState(*Child, Func);
+                }
+                else {
+                    FulfillState(*Child, Func, Parent->GetValue());
+                }
+            });
+            return Future<ResultT>(std::move(Child));
+        }
+    }
+
+    // Process wide work stealing executor
+    // Each worker owns a Chase-Lev deque per lane, tasks submitted from outside the executor go through a shared injection queue
+    class Executor {
+    public:
+        Executor(size_t WorkerCount);
+
+        ~Executor();
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        static Executor& Get();
+
+        size_t GetWorkerCount() const;
+
+        // Most tasks from Lane that can run at once
+        size_t GetLaneLimit(TaskLane Lane) const;
+
+        // Func can optionally take a const CancelToken& to check for cooperative cancellation
+        template<class FuncT>
+        auto Submit(TaskLane Lane, FuncT&& Func) {
+            using DecayedT = std::decay_t<FuncT>;
+            using ResultT = typename Detail::TaskResult<DecayedT>::Type;
+
+            auto State = std::make_shared<Detail::FutureState<ResultT>>();
+            Push(Lane, new Detail::FunctorTask<ResultT, DecayedT>(DecayedT(std::forward<FuncT>(Func)), State));
+            return Future<ResultT>(std::move(State));
+        }
+
+        // Runs a single pending task from the current task's lane or a higher priority one, if any
+        // Used to help out instead of blocking when waiting from a worker
+        bool TryRunOne();
+
+        // Returns true if the current thread is one of this executor's workers
+        bool IsWorkerThread() const;
+
+    private:
+        static constexpr size_t LaneCount = (size_t)TaskLane::Count;
+
+        struct WorkerData {
+            std::array<ChaseLevDeque<Detail::TaskBase*>, LaneCount> Queues;
+            std::thread Thread;
+        };
+
+        struct InjectionQueue {
+            std::mutex Mutex;
+            std::deque<Detail::TaskBase*> Tasks;
+        };
+
+        void Push(TaskLane Lane, Detail::TaskBase* Task);
+
+        bool TryAcquireLane(size_t Lane);
+
+        void ReleaseLane(size_t Lane);
+
+        Detail::TaskBase* TryTake(size_t Lane, WorkerData* Self, size_t StartIdx);
+
+        // Only lanes up to and including MaxLane are looked at
+        bool TryRunOne(WorkerData* Self, size_t StartIdx, size_t MaxLane);
+
+        void Wake(bool All = false);
+
+        void Worker(size_t Idx);
+
+        std::vector<std::unique_ptr<WorkerData>> Workers;
+        std::array<InjectionQueue, LaneCount> Injected;
+
+        // Interactive is never capped, the other lanes combined leave a worker free for it
+        std::array<size_t, LaneCount> LaneLimits;
+        std::array<std::atomic<size_t>, LaneCount> LaneRunning;
+        size_t NonInteractiveLimit;
+        std::atomic<size_t> NonInteractiveRunning;
+
+        std::atomic<bool> Stopping;
+
+        // Bumped whenever something a sleeping worker could run might have appeared
+        std::atomic<uint64_t> WakeEpoch;
+        std::atomic<size_t> SleepingCount;
+        std::mutex SleepMutex;
+        std::condition_variable SleepCV;
+    };
+}
\ No newline at end of file
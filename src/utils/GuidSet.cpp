@@ -0,0 +1,81 @@
+#include "GuidSet.h"
+
+#include "../srv/xorfilter/fastfilter.h"
+
+#include <algorithm>
+
+namespace EGL3::Utils {
+    static uint64_t GetFilterKey(const Guid& Guid) {
+        return ((uint64_t)Guid.A << 32 | Guid.B) ^ xor_murmur64((uint64_t)Guid.C << 32 | Guid.D);
+    }
+
+    GuidSet::GuidSet()
+    {
+
+    }
+
+    GuidSet::GuidSet(std::vector<Guid>&& Guids) :
+        Guids(std::move(Guids))
+    {
+        std::sort(this->Guids.begin(), this->Guids.end());
+        this->Guids.erase(std::unique(this->Guids.begin(), this->Guids.end()), this->Guids.end());
+
+        if (this->Guids.empty()) {
+            return;
+        }
+
+        // Different guids can share a key, and the filter can't be built with duplicate keys
+        std::vector<uint64_t> Keys;
+        Keys.reserve(this->Guids.size());
+        for (auto& Guid : this->Guids) {
+            Keys.emplace_back(GetFilterKey(Guid));
+        }
+        std::sort(Keys.begin(), Keys.end());
+        Keys.erase(std::unique(Keys.begin(), Keys.end()), Keys.end());
+
+        std::unique_ptr<xor8_s, FilterDeleter> NewFilter(new xor8_s{});
+        if (!xor8_allocate(Keys.size(), NewFilter.get())) {
+            return;
+        }
+        if (!xor8_buffered_populate(Keys.data(), Keys.size(), NewFilter.get())) {
+            return;
+        }
+        Filter = std::move(NewFilter);
+    }
+
+    GuidSet::GuidSet(GuidSet&&) noexcept = default;
+
+    GuidSet& GuidSet::operator=(GuidSet&&) noexcept = default;
+
+    GuidSet::~GuidSet() = default;
+
+    bool GuidSet::MayContain(const Guid& Guid) const
+    {
+        if (!Filter) {
+            // No filter means either empty, or it couldn't be built
+            return !Guids.empty();
+        }
+        return xor8_contain(GetFilterKey(Guid), Filter.get());
+    }
+
+    bool GuidSet::Contains(const Guid& Guid) const
+    {
+        return MayContain(Guid) && std::binary_search(Guids.begin(), Guids.end(), Guid);
+    }
+
+    size_t GuidSet::size() const
+    {
+        return Guids.size();
+    }
+
+    const std::vector<Guid>& GuidSet::GetGuids() const
+    {
+        return Guids;
+    }
+
+    void GuidSet::FilterDeleter::operator()(xor8_s* Filter) const
+    {
+        xor8_free(Filter);
+        delete Filter;
+    }
+}
\ No newline at end of file
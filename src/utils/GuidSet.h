@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Guid.h"
+
+#include <memory>
+#include <vector>
+
+struct xor8_s;
+
+namespace EGL3::Utils {
+    // Sorted set of guids with an xor filter in front of it
+    // Most lookups during update planning are misses, which the filter answers without touching the sorted list
+    class GuidSet {
+    public:
+        GuidSet();
+
+        // Duplicates are dropped, so size() can be smaller than Guids.size()
+        GuidSet(std::vector<Guid>&& Guids);
+
+        GuidSet(GuidSet&&) noexcept;
+
+        GuidSet& operator=(GuidSet&&) noexcept;
+
+        ~GuidSet();
+
+        // Never returns a false negative, false positives are around 0.4% of misses
+        bool MayContain(const Guid& Guid) const;
+
+        bool Contains(const Guid& Guid) const;
+
+        size_t size() const;
+
+        // Sorted and unique
+        const std::vector<Guid>& GetGuids() const;
+
+    private:
+        struct FilterDeleter {
+            void operator()(xor8_s* Filter) const;
+        };
+
+        std::vector<Guid> Guids;
+        std::unique_ptr<xor8_s, FilterDeleter> Filter;
+    };
+}
\ No newline at end of file
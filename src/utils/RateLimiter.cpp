@@ -0,0 +1,105 @@
+#include "RateLimiter.h"
+
+#include <algorithm>
+
+namespace EGL3::Utils {
+    RateLimiter::RateLimiter(RateLimiter* Parent) :
+        Parent(Parent),
+        Rate(0),
+        Tokens(0),
+        LastRefill(Clock::now()),
+        Generation(0),
+        Cancelled(false)
+    {
+
+    }
+
+    void RateLimiter::SetRate(uint64_t BytesPerSecond)
+    {
+        {
+            std::lock_guard Guard(Mutex);
+
+            Rate = BytesPerSecond;
+            // Debt built up under the old rate is forgiven
+            Tokens = std::clamp(Tokens, 0., Rate * BurstSeconds);
+            LastRefill = Clock::now();
+            ++Generation;
+        }
+        CV.notify_all();
+    }
+
+    uint64_t RateLimiter::GetRate() const
+    {
+        std::lock_guard Guard(Mutex);
+        return Rate;
+    }
+
+    void RateLimiter::Acquire(uint64_t Bytes)
+    {
+        Acquire(Bytes, *this);
+    }
+
+    void RateLimiter::Cancel()
+    {
+        Cancelled.store(true);
+
+        // Waiters in a parent are woken too, they check the cancellation of the limiter they started from
+        for (auto Limiter = this; Limiter; Limiter = Limiter->Parent) {
+            {
+                // Orders the store before any waiter's predicate check
+                std::lock_guard Guard(Limiter->Mutex);
+            }
+            Limiter->CV.notify_all();
+        }
+    }
+
+    void RateLimiter::Acquire(uint64_t Bytes, const RateLimiter& Origin)
+    {
+        if (Bytes == 0 || Origin.Cancelled.load()) {
+            return;
+        }
+
+        uint64_t ReservedGeneration;
+        auto Deadline = Reserve(Bytes, ReservedGeneration);
+
+        // Deadlines are absolute, so waiting on the parent first overlaps with our own wait
+        if (Parent) {
+            Parent->Acquire(Bytes, Origin);
+        }
+
+        WaitUntil(Deadline, ReservedGeneration, Origin);
+    }
+
+    RateLimiter::Clock::time_point RateLimiter::Reserve(uint64_t Bytes, uint64_t& ReservedGeneration)
+    {
+        std::lock_guard Guard(Mutex);
+
+        auto Now = Clock::now();
+        ReservedGeneration = Generation;
+        if (Rate == 0) {
+            return Now;
+        }
+
+        double Elapsed = std::chrono::duration<double>(Now - LastRefill).count();
+        LastRefill = Now;
+        Tokens = std::min(Tokens + Elapsed * Rate, Rate * BurstSeconds);
+        Tokens -= Bytes;
+        if (Tokens >= 0) {
+            return Now;
+        }
+
+        return Now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(-Tokens / Rate));
+    }
+
+    void RateLimiter::WaitUntil(Clock::time_point Deadline, uint64_t ReservedGeneration, const RateLimiter& Origin)
+    {
+        if (Deadline <= Clock::now()) {
+            return;
+        }
+
+        std::unique_lock Lock(Mutex);
+        CV.wait_until(Lock, Deadline, [this, ReservedGeneration, &Origin]() {
+            return Generation != ReservedGeneration || Origin.Cancelled.load();
+        });
+    }
+}
\ No newline at end of file
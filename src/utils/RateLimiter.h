@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace EGL3::Utils {
+    // Token bucket limiter, optionally nested under a parent that's shared with other limiters
+    // Bytes are only let through once every limiter up the chain has room for them
+    // Requests larger than the bucket aren't split, they put the bucket into debt that later requests wait out
+    class RateLimiter {
+    public:
+        RateLimiter(RateLimiter* Parent = nullptr);
+
+        RateLimiter(const RateLimiter&) = delete;
+
+        // 0 is unlimited. Takes effect immediately, anyone waiting on the old rate is let through
+        void SetRate(uint64_t BytesPerSecond);
+
+        uint64_t GetRate() const;
+
+        // Blocks until Bytes are allowed through, or until this limiter is cancelled
+        void Acquire(uint64_t Bytes);
+
+        // Releases everyone waiting on this limiter (including in its parents), later acquires return immediately
+        void Cancel();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        // How many seconds of bytes can be built up while idle
+        static constexpr double BurstSeconds = 1;
+
+        // Origin is the limiter Acquire was called on, its cancellation ends the wait
+        void Acquire(uint64_t Bytes, const RateLimiter& Origin);
+
+        // Takes the bytes out of the bucket, returns when they can be used
+        Clock::time_point Reserve(uint64_t Bytes, uint64_t& Generation);
+
+        void WaitUntil(Clock::time_point Deadline, uint64_t Generation, const RateLimiter& Origin);
+
+        RateLimiter* const Parent;
+
+        mutable std::mutex Mutex;
+        std::condition_variable CV;
+        uint64_t Rate;
+        double Tokens;
+        Clock::time_point LastRefill;
+        // Bumped on every rate change to release waiters
+        uint64_t Generation;
+        std::atomic<bool> Cancelled;
+    };
+}
\ No newline at end of file
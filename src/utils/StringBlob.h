@@ -1,17 +1,13 @@
 #pragma once
 
 #include <stdint.h>
-#include <stdlib.h>
 
 namespace EGL3::Utils {
+    // Each byte is stored as 3 decimal digits, e.g. "016000000000" is { 16, 0, 0, 0 }
+    // Done without any branches or atoi calls so the loop can be vectorized
     static void FromBlob(const char* Blob, char* Output, uint32_t OutputSize) {
-        char ConvBuf[4];
-        ConvBuf[3] = '\0';
         for (uint32_t i = 0; i < OutputSize; ++i) {
-            ConvBuf[0] = Blob[i * 3];
-            ConvBuf[1] = Blob[i * 3 + 1];
-            ConvBuf[2] = Blob[i * 3 + 2];
-            Output[i] = atoi(ConvBuf);
+            Output[i] = char((Blob[i * 3] - '0') * 100 + (Blob[i * 3 + 1] - '0') * 10 + (Blob[i * 3 + 2] - '0'));
         }
     }
 }
\ No newline at end of file
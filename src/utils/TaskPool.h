@@ -1,14 +1,16 @@
 #pragma once
 
-#include "Log.h"
 #include "Callback.h"
+#include "Executor.h"
 
+#include <algorithm>
 #include <condition_variable>
-#include <future>
-#include <shared_mutex>
-#include <vector>
+#include <mutex>
 
 namespace EGL3::Utils {
+    // Runs Task on up to Capacity executor tasks at once until it returns false
+    // Each call to Task is its own submission, so higher priority lanes get a chance in between
+    // Capacity is capped to the lane's limit, tasks past it would only sit in the queue
     class TaskPool {
     public:
         enum class PoolState : uint8_t {
@@ -18,38 +20,58 @@ namespace EGL3::Utils {
             Disposing
         };
 
-        TaskPool(size_t Capacity) :
+        TaskPool(size_t Capacity, TaskLane Lane = TaskLane::Install) :
             Task([]() { return false; }),
+            Capacity(std::min<size_t>(Capacity, Executor::Get().GetLaneLimit(Lane))),
+            Lane(Lane),
             State(PoolState::Stopped),
-            WorkerCount(0)
+            ActiveCount(0)
         {
-            Workers.reserve(Capacity);
-            for (auto i = 0; i < Capacity; ++i) {
-                Workers.emplace_back(std::async(std::launch::async, &TaskPool::Worker, this));
-            }
+
         }
 
         ~TaskPool() {
-            UpdateState(PoolState::Disposing);
+            std::unique_lock Lock(StateMutex);
+            State = PoolState::Disposing;
+            StateCV.notify_all();
 
-            for (auto& Worker : Workers) {
-                if (Worker.valid()) {
-                    Worker.get();
+            // Tasks that are still queued reference this pool
+            StateCV.wait(Lock, [this]() {
+                return ActiveCount == 0;
+            });
+        }
+
+        void SetRunning(bool Running = true) {
+            size_t SubmitCount = 0;
+            {
+                std::lock_guard Lock(StateMutex);
+                if (State == PoolState::Completed || State == PoolState::Disposing) {
+                    return;
                 }
+                State = Running ? PoolState::Running : PoolState::Stopped;
+                if (Running) {
+                    SubmitCount = Capacity - ActiveCount;
+                    ActiveCount = Capacity;
+                }
+            }
+            StateCV.notify_all();
+
+            for (size_t i = 0; i < SubmitCount; ++i) {
+                Submit();
             }
         }
 
-        void SetRunning(bool Running = true) {
-            UpdateState(Running ? PoolState::Running : PoolState::Stopped);
+        size_t GetCapacity() const {
+            return Capacity;
         }
 
         PoolState GetState() const {
-            std::shared_lock Lock(StateMutex);
+            std::lock_guard Lock(StateMutex);
             return State;
         }
 
         void WaitUntilResumed() const {
-            std::shared_lock Lock(StateMutex);
+            std::unique_lock Lock(StateMutex);
             StateCV.wait(Lock, [this]() {
                 return State != PoolState::Stopped;
             });
@@ -58,56 +80,56 @@ namespace EGL3::Utils {
         // returns true if stopped before the timeout, returns false if timeout completed
         template <class Clock, class Duration>
         bool WaitUntilFinished(const std::chrono::time_point<Clock, Duration>& Timeout) const {
-            std::unique_lock Lock(WorkerMutex);
-            return WorkerCV.wait_until(Lock, Timeout, [this]() {
-                return WorkerCount == 0;
+            std::unique_lock Lock(StateMutex);
+            return StateCV.wait_until(Lock, Timeout, [this]() {
+                return ActiveCount == 0 && (State == PoolState::Completed || State == PoolState::Disposing);
             });
         }
 
         Utils::Callback<bool()> Task;
 
     private:
-        void UpdateState(PoolState NewState) {
-            {
-                std::lock_guard Lock(StateMutex);
-                State = NewState;
-            }
-            StateCV.notify_all();
+        void Submit() {
+            Executor::Get().Submit(Lane, [this]() { RunOnce(); });
         }
 
-        void Worker() {
+        void RunOnce() {
             {
-                std::lock_guard Guard(WorkerMutex);
-                ++WorkerCount;
-            }
-            WorkerCV.notify_all();
-
-            do {
-                std::shared_lock Lock(StateMutex);
-                StateCV.wait(Lock, [this]() {
-                    return State != PoolState::Stopped;
-                });
-                if (State == PoolState::Disposing) {
+                std::lock_guard Lock(StateMutex);
+                if (State != PoolState::Running) {
+                    Retire();
                     return;
                 }
-            } while (Task());
-            UpdateState(PoolState::Completed);
+            }
+
+            bool HasMore = Task();
 
             {
-                std::lock_guard Guard(WorkerMutex);
-                --WorkerCount;
+                std::lock_guard Lock(StateMutex);
+                if (!HasMore && State != PoolState::Disposing) {
+                    State = PoolState::Completed;
+                }
+                if (State != PoolState::Running) {
+                    Retire();
+                    return;
+                }
             }
-            WorkerCV.notify_all();
+
+            Submit();
         }
 
-        mutable std::shared_mutex StateMutex;
-        mutable std::condition_variable_any StateCV;
-        PoolState State;
+        // StateMutex must be held
+        void Retire() {
+            --ActiveCount;
+            StateCV.notify_all();
+        }
 
-        mutable std::condition_variable WorkerCV;
-        mutable std::mutex WorkerMutex;
-        size_t WorkerCount;
+        const size_t Capacity;
+        const TaskLane Lane;
 
-        std::vector<std::future<void>> Workers;
+        mutable std::mutex StateMutex;
+        mutable std::condition_variable StateCV;
+        PoolState State;
+        size_t ActiveCount;
     };
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "ThroughputEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace EGL3::Utils {
+    ThroughputEstimator::ThroughputEstimator(std::chrono::nanoseconds TimeConstant) :
+        TimeConstant(std::chrono::duration<double>(TimeConstant).count())
+    {
+        Reset();
+    }
+
+    void ThroughputEstimator::Reset()
+    {
+        HasBaseline = false;
+        HasSample = false;
+        LastElapsed = std::chrono::nanoseconds::zero();
+        LastTotal = 0;
+        Rate = 0;
+        Variance = 0;
+    }
+
+    void ThroughputEstimator::Update(std::chrono::nanoseconds Elapsed, uint64_t Total)
+    {
+        // The counter was restarted, start over from here
+        if (!HasBaseline || Total < LastTotal || Elapsed < LastElapsed) {
+            Reset();
+            HasBaseline = true;
+            LastElapsed = Elapsed;
+            LastTotal = Total;
+            return;
+        }
+
+        double Delta = std::chrono::duration<double>(Elapsed - LastElapsed).count();
+        if (Delta <= 0) {
+            return;
+        }
+
+        double Sample = (Total - LastTotal) / Delta;
+        LastElapsed = Elapsed;
+        LastTotal = Total;
+
+        if (!HasSample) {
+            HasSample = true;
+            Rate = Sample;
+            Variance = 0;
+            return;
+        }
+
+        double Alpha = 1 - std::exp(-Delta / TimeConstant);
+        double Diff = Sample - Rate;
+        Rate += Alpha * Diff;
+        Variance = (1 - Alpha) * (Variance + Alpha * Diff * Diff);
+    }
+
+    bool ThroughputEstimator::HasRate() const
+    {
+        return HasSample;
+    }
+
+    double ThroughputEstimator::GetRate() const
+    {
+        return Rate;
+    }
+
+    double ThroughputEstimator::GetDeviation() const
+    {
+        return std::sqrt(Variance);
+    }
+
+    std::chrono::nanoseconds ThroughputEstimator::GetTimeLeft(uint64_t Remaining, double Deviations) const
+    {
+        if (Remaining == 0) {
+            return std::chrono::nanoseconds::zero();
+        }
+
+        double ShiftedRate = Rate + Deviations * GetDeviation();
+        if (!HasSample || ShiftedRate <= 0) {
+            return std::chrono::nanoseconds::max();
+        }
+
+        // Anything past this is as good as never
+        double Seconds = std::min(Remaining / ShiftedRate, 60. * 60 * 24 * 365);
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(Seconds));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+
+namespace EGL3::Utils {
+    // Smooths a running byte counter into a rate with an exponentially weighted mean and variance
+    // Samples are weighted by how much time they cover, so irregular update intervals don't skew it
+    class ThroughputEstimator {
+    public:
+        // Roughly how far back samples still matter
+        ThroughputEstimator(std::chrono::nanoseconds TimeConstant = std::chrono::seconds(10));
+
+        void Reset();
+
+        // Elapsed shouldn't include time spent paused, Total is the counter's current value
+        // The first update only sets the baseline
+        void Update(std::chrono::nanoseconds Elapsed, uint64_t Total);
+
+        bool HasRate() const;
+
+        // Bytes per second
+        double GetRate() const;
+
+        double GetDeviation() const;
+
+        // Time to get through Remaining bytes at the rate shifted by Deviations standard deviations
+        // Returns nanoseconds::max() if there's no rate to go off of
+        std::chrono::nanoseconds GetTimeLeft(uint64_t Remaining, double Deviations = 0) const;
+
+    private:
+        double TimeConstant;
+
+        bool HasBaseline;
+        bool HasSample;
+        std::chrono::nanoseconds LastElapsed;
+        uint64_t LastTotal;
+
+        double Rate;
+        double Variance;
+    };
+}
\ No newline at end of file
@@ -7,9 +7,9 @@
 #include "../HashCombine.h"
 #include "../KnownFolders.h"
 #include "../Platform.h"
-#include "../SHA.h"
+#include "../SHABuilder.h"
 
-#include <numeric>
+#include <algorithm>
 
 namespace EGL3::Utils::EGL {
     using namespace Web::Epic::BPS;
@@ -108,7 +108,8 @@ namespace EGL3::Utils::EGL {
         PARSE_END
     };
 
-    ChunkProvider::ChunkProvider(Storage::Game::GameId Id)
+    ChunkProvider::ChunkProvider(Storage::Game::GameId Id) :
+        OpenFiles(std::make_unique<FileCache>())
     {
         auto ItemFolder = GetInstalledItemFolderPath();
         if (ItemFolder.empty()) {
@@ -185,33 +186,106 @@ namespace EGL3::Utils::EGL {
 
     bool ChunkProvider::IsChunkProbablyAvailable(const Utils::Guid& Guid) const
     {
-        return LUT.find(Guid) != LUT.end();
+        return AvailableChunks.MayContain(Guid);
     }
 
     std::unique_ptr<char[]> ChunkProvider::GetChunk(const Utils::Guid& Guid) const
     {
-        auto ChunkDataItr = LUT.find(Guid);
-        if (ChunkDataItr == LUT.end()) {
+        auto Chunk = FindChunk(Guid);
+        if (!Chunk) {
             return nullptr;
         }
 
-        auto& ChunkData = ChunkDataItr->second;
-        auto Data = std::make_unique<char[]>(ChunkData.Info.WindowSize);
+        auto Data = std::make_unique<char[]>(Chunk->Info.WindowSize);
+        if (!ReadChunk(Guid, [&Data](uint32_t ChunkOffset, const char* Section, uint32_t Size) { memcpy(Data.get() + ChunkOffset, Section, Size); })) {
+            return nullptr;
+        }
+
+        return Data;
+    }
+
+    bool ChunkProvider::ReadChunk(const Utils::Guid& Guid, const SectionWriter& Writer) const
+    {
+        auto Chunk = FindChunk(Guid);
+        if (!Chunk) {
+            return false;
+        }
+
+        Utils::SHA1Builder Builder;
+
+        // Parts of the window that no file uses are hashed and written as zeros
+        uint32_t Covered = 0;
+        auto FillZeros = [&](uint32_t End) {
+            static constexpr char Zeros[4096]{};
+            while (Covered < End) {
+                auto Size = std::min<uint32_t>(End - Covered, sizeof(Zeros));
+                Builder.Update(Zeros, Size);
+                Writer(Covered, Zeros, Size);
+                Covered += Size;
+            }
+        };
 
-        for (auto& Section : ChunkData.Sections) {
-            Utils::Streams::FileStream Stream;
-            if (!Stream.open(InstallLocation / *Section.File, "rb")) {
-                return nullptr;
+        auto SectionsBegin = Sections.begin() + Chunk->SectionIdx;
+        for (auto Itr = SectionsBegin; Itr != SectionsBegin + Chunk->SectionCount; ++Itr) {
+            auto File = GetFile(Itr->FileIdx);
+            if (!File || File->Size() < Itr->FileOffset + Itr->Size) {
+                return false;
             }
-            Stream.seek(Section.FileOffset, Utils::Streams::Stream::Beg);
-            Stream.read(Data.get() + Section.ChunkOffset, Section.Size);
+
+            FillZeros(Itr->ChunkOffset);
+
+            auto Data = File->Get() + Itr->FileOffset;
+            Builder.Update(Data, Itr->Size);
+            Writer(Itr->ChunkOffset, Data, Itr->Size);
+            Covered = Itr->ChunkOffset + Itr->Size;
         }
+        FillZeros(Chunk->Info.WindowSize);
+
+        char SHA[20];
+        Builder.Finish(SHA);
+        return !Builder.HasError() && memcmp(SHA, Chunk->Info.SHAHash, sizeof(SHA)) == 0;
+    }
 
-        if (!Utils::SHA1Verify(Data.get(), ChunkData.Info.WindowSize, ChunkData.Info.SHAHash)) {
+    const ChunkProvider::ChunkData* ChunkProvider::FindChunk(const Utils::Guid& Guid) const
+    {
+        if (!AvailableChunks.MayContain(Guid)) {
             return nullptr;
         }
 
-        return Data;
+        auto Itr = std::lower_bound(LUT.begin(), LUT.end(), Guid, [](const ChunkData& Chunk, const Utils::Guid& Guid) {
+            return Chunk.Info.Guid < Guid;
+        });
+        if (Itr == LUT.end() || Itr->Info.Guid != Guid) {
+            return nullptr;
+        }
+        return &*Itr;
+    }
+
+    std::shared_ptr<const Utils::Mmio::MmioFile> ChunkProvider::GetFile(uint32_t FileIdx) const
+    {
+        std::lock_guard Guard(OpenFiles->Mutex);
+
+        auto& Files = OpenFiles->Files;
+        auto Itr = std::find_if(Files.begin(), Files.end(), [FileIdx](const OpenFile& File) {
+            return File.FileIdx == FileIdx;
+        });
+        if (Itr != Files.end()) {
+            Files.splice(Files.begin(), Files, Itr);
+            return Itr->File;
+        }
+
+        // Mapping happens under the lock so two workers never map the same file twice
+        // Evicted files stay mapped until the last reader lets go of them
+        auto File = std::make_shared<const Utils::Mmio::MmioFile>(InstallLocation / Filenames[FileIdx], Utils::Mmio::OptionRead);
+        if (!File->IsValid()) {
+            return nullptr;
+        }
+
+        Files.emplace_front(OpenFile{ FileIdx, File });
+        if (Files.size() > MaxOpenFiles) {
+            Files.pop_back();
+        }
+        return File;
     }
 
     std::filesystem::path ChunkProvider::GetInstalledItemFolderPath()
@@ -237,21 +311,74 @@ namespace EGL3::Utils::EGL {
 
     void ChunkProvider::SetupLUT(Web::Epic::BPS::Manifest&& Manifest)
     {
-        LUT.reserve(Manifest.ChunkDataList.ChunkList.size());
-        for (auto& Chunk : Manifest.ChunkDataList.ChunkList) {
-            LUT.emplace(Chunk.Guid, ChunkData{ .Info = std::move(Chunk) });
-        }
-
+        auto& Chunks = Manifest.ChunkDataList.ChunkList;
+        std::sort(Chunks.begin(), Chunks.end(), [](const ChunkInfo& A, const ChunkInfo& B) {
+            return A.Guid < B.Guid;
+        });
+
+        auto GetChunkIdx = [&Chunks](const Utils::Guid& Guid) -> size_t {
+            auto Itr = std::lower_bound(Chunks.begin(), Chunks.end(), Guid, [](const ChunkInfo& Chunk, const Utils::Guid& Guid) {
+                return Chunk.Guid < Guid;
+            });
+            return Itr != Chunks.end() && Itr->Guid == Guid ? size_t(Itr - Chunks.begin()) : Chunks.size();
+        };
+
+        // Gather every section first, then group them by chunk
+        std::vector<std::pair<size_t, ChunkSection>> AllSections;
         auto& Files = Manifest.FileManifestList.FileList;
         Filenames.reserve(Files.size());
         for (auto& File : Files) {
-            auto& Filename = Filenames.emplace_back(std::move(File.Filename));
-            size_t FileOffset = 0;
+            uint32_t FileIdx = Filenames.size();
+            Filenames.emplace_back(std::move(File.Filename));
+            uint64_t FileOffset = 0;
             for (auto& Part : File.ChunkParts) {
-                auto& ChunkData = LUT.at(Part.Guid);
-                auto& Section = ChunkData.Sections.emplace_back(ChunkSection{ &Filename, FileOffset, Part.Offset, Part.Size });
+                auto ChunkIdx = GetChunkIdx(Part.Guid);
+                if (ChunkIdx != Chunks.size()) {
+                    AllSections.emplace_back(ChunkIdx, ChunkSection{ FileIdx, Part.Offset, Part.Size, FileOffset });
+                }
                 FileOffset += Part.Size;
             }
         }
+
+        std::sort(AllSections.begin(), AllSections.end(), [](const auto& A, const auto& B) {
+            if (A.first != B.first) {
+                return A.first < B.first;
+            }
+            if (A.second.ChunkOffset != B.second.ChunkOffset) {
+                return A.second.ChunkOffset < B.second.ChunkOffset;
+            }
+            return A.second.Size > B.second.Size;
+        });
+
+        // The same part of a chunk can be used by multiple files, only one copy is needed
+        // Sections end up ordered and not overlapping, ReadChunk fills the gaps between them
+        std::vector<Utils::Guid> Guids;
+        Guids.reserve(Chunks.size());
+        LUT.reserve(Chunks.size());
+        Sections.reserve(AllSections.size());
+        for (auto Itr = AllSections.begin(); Itr != AllSections.end();) {
+            auto& Chunk = Chunks[Itr->first];
+            auto SectionIdx = Sections.size();
+            uint32_t Covered = 0;
+            for (; Itr != AllSections.end() && &Chunks[Itr->first] == &Chunk; ++Itr) {
+                auto Section = Itr->second;
+                uint32_t SectionEnd = std::min<uint32_t>(Section.ChunkOffset + Section.Size, Chunk.WindowSize);
+                if (SectionEnd <= Covered || Section.ChunkOffset >= SectionEnd) {
+                    continue;
+                }
+                auto Overlap = Section.ChunkOffset < Covered ? Covered - Section.ChunkOffset : 0;
+                Section.ChunkOffset += Overlap;
+                Section.FileOffset += Overlap;
+                Section.Size = SectionEnd - Section.ChunkOffset;
+                Sections.emplace_back(Section);
+                Covered = SectionEnd;
+            }
+
+            Guids.emplace_back(Chunk.Guid);
+            LUT.emplace_back(ChunkData{ .Info = Chunk, .SectionIdx = (uint32_t)SectionIdx, .SectionCount = uint32_t(Sections.size() - SectionIdx) });
+        }
+        Sections.shrink_to_fit();
+
+        AvailableChunks = Utils::GuidSet(std::move(Guids));
     }
-}
+}
\ No newline at end of file
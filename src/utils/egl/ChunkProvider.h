@@ -4,6 +4,12 @@
 #include "../../web/epic/bps/ChunkData.h"
 #include "../../web/epic/bps/Manifest.h"
 #include "../../web/Response.h"
+#include "../GuidSet.h"
+#include "../mmio/MmioFile.h"
+
+#include <functional>
+#include <list>
+#include <mutex>
 
 namespace EGL3::Utils::EGL {
     class ChunkProvider {
@@ -18,27 +24,60 @@ namespace EGL3::Utils::EGL {
 
         std::unique_ptr<char[]> GetChunk(const Utils::Guid& Guid) const;
 
+        // Called with each section of the chunk in order, ranges no file covers are passed as zeros
+        // Data is only valid during the call
+        using SectionWriter = std::function<void(uint32_t ChunkOffset, const char* Data, uint32_t Size)>;
+
+        // Gathers the chunk straight out of the mapped install files, hashing it along the way
+        // Returns false if the chunk isn't available or doesn't match its SHA, in which case
+        // Writer may have already been called with some (or all) of its sections
+        bool ReadChunk(const Utils::Guid& Guid, const SectionWriter& Writer) const;
+
     private:
         static std::filesystem::path GetInstalledItemFolderPath();
 
         void SetupLUT(Web::Epic::BPS::Manifest&& Manifest);
 
         struct ChunkSection {
-            const std::string* File;
-            size_t FileOffset;
+            uint32_t FileIdx;
             uint32_t ChunkOffset;
             uint32_t Size;
+            uint64_t FileOffset;
         };
 
+        // Sections are stored in one array, each chunk owns a contiguous run of them sorted by ChunkOffset
         struct ChunkData {
-            std::vector<ChunkSection> Sections;
-            const Web::Epic::BPS::ChunkInfo Info;
+            Web::Epic::BPS::ChunkInfo Info;
+            uint32_t SectionIdx;
+            uint32_t SectionCount;
+        };
+
+        const ChunkData* FindChunk(const Utils::Guid& Guid) const;
+
+        std::shared_ptr<const Utils::Mmio::MmioFile> GetFile(uint32_t FileIdx) const;
+
+        // Keeping every file of an install mapped would use up too many handles
+        static constexpr size_t MaxOpenFiles = 32;
+
+        struct OpenFile {
+            uint32_t FileIdx;
+            std::shared_ptr<const Utils::Mmio::MmioFile> File;
+        };
+
+        struct FileCache {
+            std::mutex Mutex;
+            // Most recently used first
+            std::list<OpenFile> Files;
         };
 
         std::filesystem::path InstallLocation;
-        std::vector<Web::Epic::BPS::ChunkInfo> ChunkInfos;
         std::vector<std::string> Filenames;
-        std::unordered_map<Utils::Guid, ChunkData> LUT;
+        // Sorted by guid
+        std::vector<ChunkData> LUT;
+        std::vector<ChunkSection> Sections;
+        Utils::GuidSet AvailableChunks;
+        // Behind a pointer so the provider can still be moved between install states
+        std::unique_ptr<FileCache> OpenFiles;
 
     };
 }
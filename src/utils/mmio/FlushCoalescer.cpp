@@ -0,0 +1,83 @@
+#include "FlushCoalescer.h"
+
+#include <algorithm>
+
+namespace EGL3::Utils::Mmio {
+    FlushCoalescer::FlushCoalescer(size_t ByteBudget, std::chrono::milliseconds TimeBudget) :
+        ByteBudget(ByteBudget),
+        TimeBudget(TimeBudget),
+        DirtyBytes(0)
+    {
+
+    }
+
+    std::vector<FlushCoalescer::Range> FlushCoalescer::Add(size_t Position, size_t Size)
+    {
+        if (Size == 0) {
+            return {};
+        }
+
+        std::lock_guard Guard(Mutex);
+
+        if (Ranges.empty()) {
+            OldestDirty = Clock::now();
+        }
+
+        size_t Start = Position;
+        size_t End = Position + Size;
+
+        // Merge with the range before it if they touch
+        auto Itr = Ranges.upper_bound(Start);
+        if (Itr != Ranges.begin()) {
+            auto Prev = std::prev(Itr);
+            if (Prev->second >= Start) {
+                Start = Prev->first;
+                End = std::max(End, Prev->second);
+                DirtyBytes -= Prev->second - Prev->first;
+                Itr = Ranges.erase(Prev);
+            }
+        }
+
+        // And every range after it that it now touches
+        while (Itr != Ranges.end() && Itr->first <= End) {
+            End = std::max(End, Itr->second);
+            DirtyBytes -= Itr->second - Itr->first;
+            Itr = Ranges.erase(Itr);
+        }
+
+        Ranges.emplace_hint(Itr, Start, End);
+        DirtyBytes += End - Start;
+
+        if (DirtyBytes < ByteBudget && Clock::now() - OldestDirty < TimeBudget) {
+            return {};
+        }
+        return TakeAllLocked();
+    }
+
+    std::vector<FlushCoalescer::Range> FlushCoalescer::TakeAll()
+    {
+        std::lock_guard Guard(Mutex);
+
+        return TakeAllLocked();
+    }
+
+    size_t FlushCoalescer::GetDirtyBytes() const
+    {
+        std::lock_guard Guard(Mutex);
+
+        return DirtyBytes;
+    }
+
+    std::vector<FlushCoalescer::Range> FlushCoalescer::TakeAllLocked()
+    {
+        std::vector<Range> Ret;
+        Ret.reserve(Ranges.size());
+        for (auto& [Start, End] : Ranges) {
+            Ret.emplace_back(Range{ Start, End - Start });
+        }
+
+        Ranges.clear();
+        DirtyBytes = 0;
+        return Ret;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace EGL3::Utils::Mmio {
+    // Collects the byte ranges of a mapping that were written to, so they can be written back
+    // in a few large requests instead of one per write. Adjacent and overlapping ranges are merged
+    class FlushCoalescer {
+    public:
+        struct Range {
+            size_t Position;
+            size_t Size;
+        };
+
+        static constexpr size_t DefaultByteBudget = 64ull * 1024 * 1024;
+        static constexpr std::chrono::milliseconds DefaultTimeBudget{ 2000 };
+
+        FlushCoalescer(size_t ByteBudget = DefaultByteBudget, std::chrono::milliseconds TimeBudget = DefaultTimeBudget);
+
+        // Returns the ranges that should be written back now, empty until the byte or time budget runs out
+        std::vector<Range> Add(size_t Position, size_t Size);
+
+        // Returns every pending range, for when everything has to be durable
+        std::vector<Range> TakeAll();
+
+        size_t GetDirtyBytes() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        std::vector<Range> TakeAllLocked();
+
+        const size_t ByteBudget;
+        const Clock::duration TimeBudget;
+
+        mutable std::mutex Mutex;
+        // Start -> end of each dirty range, none of them touch
+        std::map<size_t, size_t> Ranges;
+        size_t DirtyBytes;
+        Clock::time_point OldestDirty;
+    };
+}
\ No newline at end of file
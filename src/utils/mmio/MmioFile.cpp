@@ -3,6 +3,7 @@
 #include "../Align.h"
 #include "../Log.h"
 #include "ntdll.h"
+#include "WorkingSetGovernor.h"
 
 #include <Psapi.h>
 
@@ -10,6 +11,7 @@ namespace EGL3::Utils::Mmio {
     MmioFile::MmioFile(bool Readonly) :
         Readonly(Readonly),
         BaseAddress(NULL),
+        HFile(NULL),
         HSection(NULL),
         HProcess(GetCurrentProcess()),
         SectionSize(),
@@ -39,15 +41,21 @@ namespace EGL3::Utils::Mmio {
     MmioFile::MmioFile(const char* FilePath, Detail::ERead) :
         MmioFile(true)
     {
-        HANDLE HFile = CreateFile(FilePath, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-        if (HFile != INVALID_HANDLE_VALUE) {
+        // Other readers (like the launcher the file came from) are fine, the mapping only needs the file to not change
+        HFile = CreateFile(FilePath, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (HFile == INVALID_HANDLE_VALUE) {
+            HFile = NULL;
+        }
+        else {
             EGL3_VERIFY(GetFileSizeEx(HFile, (PLARGE_INTEGER)&SectionSize), "Failed to get file size");
             EGL3_VERIFY(SectionSize, "Trying to mmio open file without any data");
 
             auto Status = NtCreateSection(&HSection, SECTION_MAP_READ,
                 NULL, (PLARGE_INTEGER)&SectionSize, PAGE_READONLY, SEC_COMMIT, HFile);
 
+            // The section keeps the file referenced, and reads never go through the handle
             CloseHandle(HFile);
+            HFile = NULL;
 
             if (0 <= Status) {
                 ViewSize = SectionSize;
@@ -55,6 +63,7 @@ namespace EGL3::Utils::Mmio {
                     &ViewSize, ViewUnmap, 0, PAGE_READONLY);
 
                 EGL3_VERIFY(0 <= Status, "Failed to map file");
+                WorkingSetGovernor::Get().Register(this);
             }
         }
     }
@@ -62,8 +71,11 @@ namespace EGL3::Utils::Mmio {
     MmioFile::MmioFile(const char* FilePath, Detail::EWrite) :
         MmioFile(false)
     {
-        HANDLE HFile = CreateFile(FilePath, GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-        if (HFile != INVALID_HANDLE_VALUE) {
+        HFile = CreateFile(FilePath, GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (HFile == INVALID_HANDLE_VALUE) {
+            HFile = NULL;
+        }
+        else {
             EGL3_VERIFY(GetFileSizeEx(HFile, (PLARGE_INTEGER)&SectionSize), "Failed to get file size");
             if (SectionSize == 0) {
                 SectionSize = 0x1000;
@@ -72,7 +84,7 @@ namespace EGL3::Utils::Mmio {
             auto Status = NtCreateSection(&HSection, SECTION_EXTEND_SIZE | SECTION_MAP_READ | SECTION_MAP_WRITE,
                 NULL, (PLARGE_INTEGER)&SectionSize, PAGE_READWRITE, SEC_COMMIT, HFile);
 
-            CloseHandle(HFile);
+            // Kept open for Write, cached writes go through the same pages the view maps
 
             if (0 <= Status) {
                 ViewSize = InitialViewSize;
@@ -80,6 +92,7 @@ namespace EGL3::Utils::Mmio {
                     &ViewSize, ViewUnmap, MEM_RESERVE, PAGE_READWRITE);
 
                 EGL3_VERIFY(0 <= Status, "Failed to map file");
+                WorkingSetGovernor::Get().Register(this);
             }
         }
     }
@@ -87,25 +100,41 @@ namespace EGL3::Utils::Mmio {
     MmioFile::MmioFile(MmioFile&& Other) noexcept :
         Readonly(Other.Readonly),
         HProcess(Other.HProcess),
+        HFile(Other.HFile),
         HSection(Other.HSection),
         BaseAddress(Other.BaseAddress),
         SectionSize(Other.SectionSize),
         ViewSize(Other.ViewSize)
     {
+        if (BaseAddress) {
+            WorkingSetGovernor::Get().Replace(&Other, this);
+        }
         Other.BaseAddress = NULL;
+        Other.HFile = NULL;
         Other.HSection = NULL;
     }
 
     MmioFile::~MmioFile()
     {
         if (BaseAddress) {
-            Flush();
+            WorkingSetGovernor::Get().Unregister(this);
+
+            // Readonly views have nothing to write back, and trimming the whole process' working set
+            // every time one closes is too costly when they're opened and closed often
+            if (!Readonly) {
+                Flush();
+            }
             NtUnmapViewOfSection(HProcess, BaseAddress);
-            EmptyWorkingSet(HProcess);
+            if (!Readonly) {
+                EmptyWorkingSet(HProcess);
+            }
         }
         if (HSection) {
             NtClose(HSection);
         }
+        if (HFile) {
+            CloseHandle(HFile);
+        }
     }
 
     bool ResolveDevicePath(std::string& Filename) {
@@ -145,6 +174,8 @@ namespace EGL3::Utils::Mmio {
 
     void MmioFile::EnsureSize(size_t Size)
     {
+        std::lock_guard Guard(ResizeMutex);
+
         if (SectionSize < Size) {
             SectionSize = Size;
             auto Status = NtExtendSection(HSection, (PLARGE_INTEGER)&SectionSize);
@@ -165,11 +196,49 @@ namespace EGL3::Utils::Mmio {
         }
     }
 
+    bool MmioFile::Write(size_t Position, const void* Data, size_t Size)
+    {
+        if (!HFile) {
+            return false;
+        }
+
+        // Writing past the section would grow the file without the section knowing
+        if (Position + Size > (size_t)SectionSize) {
+            return false;
+        }
+
+        while (Size) {
+            DWORD WriteSize = Size > MaxWriteSize ? MaxWriteSize : (DWORD)Size;
+
+            OVERLAPPED Overlapped{};
+            Overlapped.Offset = (DWORD)Position;
+            Overlapped.OffsetHigh = (DWORD)(Position >> 32);
+
+            DWORD BytesWritten = 0;
+            if (!WriteFile(HFile, Data, WriteSize, &BytesWritten, &Overlapped) || BytesWritten == 0) {
+                return false;
+            }
+
+            Position += BytesWritten;
+            Data = (const char*)Data + BytesWritten;
+            Size -= BytesWritten;
+        }
+        return true;
+    }
+
     void MmioFile::Flush(size_t Position, size_t Size)
     {
         VirtualUnlock(Get() + Position, Size);
     }
 
+    void MmioFile::WriteBack(size_t Position, size_t Size)
+    {
+        SIZE_T FlushSize = Size;
+        PVOID FlushAddr = Get() + Position;
+        IO_STATUS_BLOCK Block;
+        NtFlushVirtualMemory(HProcess, &FlushAddr, &FlushSize, &Block);
+    }
+
     void MmioFile::Flush()
     {
         SIZE_T FlushSize = 0;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <filesystem>
+#include <mutex>
 
 namespace EGL3::Utils::Mmio {
     namespace Detail {
@@ -68,21 +69,35 @@ namespace EGL3::Utils::Mmio {
 
         void EnsureSize(size_t Size);
 
+        // Writes through the file instead of the view, both see the same data
+        // Returns false if the file can't be written to this way, the view can still be used instead
+        bool Write(size_t Position, const void* Data, size_t Size);
+
+        // Lets the range leave the working set, doesn't write it out
         void Flush(size_t Position, size_t Size);
 
+        // Writes the range's dirty pages out to the file
+        void WriteBack(size_t Position, size_t Size);
+
         void Flush();
 
         static bool SetWorkingSize(uint64_t MaxBytes, uint64_t MinBytes = 1024 * 1024 * 64);
 
     private:
+        friend class WorkingSetGovernor;
+
         const bool Readonly;
         MM_HANDLE HProcess;
+        MM_HANDLE HFile;
         MM_HANDLE HSection;
         MM_PVOID BaseAddress;
         MM_LARGE_INTEGER SectionSize;
         MM_SIZE_T ViewSize;
+        // Held while the section is extended and the view is remapped, so the base address and size are read together
+        mutable std::mutex ResizeMutex;
 
         static constexpr MM_SIZE_T InitialViewSize = 1ull << 37; // 128 gb
         static constexpr MM_SIZE_T ViewSizeIncrement = 1ull << 37; // 128 gb
+        static constexpr unsigned long MaxWriteSize = 1ul << 30; // 1 gb
     };
 }
\ No newline at end of file
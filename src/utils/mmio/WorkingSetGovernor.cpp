@@ -0,0 +1,169 @@
+#include "WorkingSetGovernor.h"
+
+#include "MmioFile.h"
+
+#include <algorithm>
+#include <limits>
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+
+namespace EGL3::Utils::Mmio {
+    static constexpr size_t PageSize = 4096;
+
+    WorkingSetGovernor& WorkingSetGovernor::Get()
+    {
+        static WorkingSetGovernor Instance;
+        return Instance;
+    }
+
+    WorkingSetGovernor::WorkingSetGovernor() :
+        Tick(0),
+        BudgetBytes(std::numeric_limits<uint64_t>::max()),
+        ResidentBytes(0),
+        TrimmedBytes(0)
+    {
+
+    }
+
+    void WorkingSetGovernor::SetBudget(uint64_t Bytes)
+    {
+        std::lock_guard Guard(Mutex);
+
+        BudgetBytes = Bytes;
+    }
+
+    void WorkingSetGovernor::Enforce()
+    {
+        std::lock_guard Guard(Mutex);
+
+        ++Tick;
+
+        if (Files.empty()) {
+            Granules.clear();
+            ResidentBytes = 0;
+            return;
+        }
+
+        // The first element is the entry count, the rest are the entries
+        if (WorkingSetBuffer.empty()) {
+            WorkingSetBuffer.resize(1 << 16);
+        }
+        while (!QueryWorkingSet(GetCurrentProcess(), WorkingSetBuffer.data(), DWORD(WorkingSetBuffer.size() * sizeof(uintptr_t)))) {
+            if (GetLastError() != ERROR_BAD_LENGTH) {
+                return;
+            }
+            // It can grow between calls, leave some room
+            WorkingSetBuffer.resize(WorkingSetBuffer[0] + WorkingSetBuffer[0] / 4 + 2);
+        }
+
+        // Another thread can extend a file and remap its view at any time, so each view is read under the file's resize lock
+        struct FileView {
+            MmioFile* File;
+            const char* Base;
+            size_t Size;
+        };
+        std::vector<FileView> Views;
+        Views.reserve(Files.size());
+        for (auto File : Files) {
+            std::lock_guard FileGuard(File->ResizeMutex);
+            Views.emplace_back(FileView{ File, File->Get(), File->Size() });
+        }
+
+        std::map<std::pair<MmioFile*, size_t>, uint32_t> Counts;
+        for (size_t i = 1; i <= WorkingSetBuffer[0]; ++i) {
+            auto Address = (const char*)(WorkingSetBuffer[i] & ~(PageSize - 1));
+            for (auto& View : Views) {
+                if (Address >= View.Base && Address < View.Base + View.Size) {
+                    ++Counts[{ View.File, size_t(Address - View.Base) / GranuleSize }];
+                    break;
+                }
+            }
+        }
+
+        ResidentBytes = 0;
+        std::erase_if(Granules, [&](const auto& Entry) {
+            return !Counts.contains(Entry.first);
+        });
+        for (auto& [Key, ResidentPages] : Counts) {
+            auto [Itr, Inserted] = Granules.try_emplace(Key, Granule{ 0, Tick });
+            if (ResidentPages > Itr->second.ResidentPages) {
+                Itr->second.LastActive = Tick;
+            }
+            Itr->second.ResidentPages = ResidentPages;
+            ResidentBytes += ResidentPages * PageSize;
+        }
+
+        if (ResidentBytes <= BudgetBytes) {
+            return;
+        }
+
+        // Least recently grown first
+        std::vector<std::map<std::pair<MmioFile*, size_t>, Granule>::iterator> Order;
+        Order.reserve(Granules.size());
+        for (auto Itr = Granules.begin(); Itr != Granules.end(); ++Itr) {
+            Order.emplace_back(Itr);
+        }
+        std::sort(Order.begin(), Order.end(), [](const auto& A, const auto& B) {
+            return A->second.LastActive < B->second.LastActive;
+        });
+
+        for (auto Itr : Order) {
+            if (ResidentBytes <= BudgetBytes) {
+                break;
+            }
+
+            auto& [File, GranuleIdx] = Itr->first;
+            size_t Position = GranuleIdx * GranuleSize;
+            {
+                std::lock_guard FileGuard(File->ResizeMutex);
+                File->Flush(Position, std::min<size_t>(GranuleSize, File->Size() - Position));
+            }
+
+            uint64_t Trimmed = Itr->second.ResidentPages * PageSize;
+            ResidentBytes -= Trimmed;
+            TrimmedBytes += Trimmed;
+            Granules.erase(Itr);
+        }
+    }
+
+    WorkingSetGovernor::Stats WorkingSetGovernor::GetStats() const
+    {
+        std::lock_guard Guard(Mutex);
+
+        return Stats{
+            .BudgetBytes = BudgetBytes,
+            .ResidentBytes = ResidentBytes,
+            .TrimmedBytes = TrimmedBytes
+        };
+    }
+
+    void WorkingSetGovernor::Register(MmioFile* File)
+    {
+        std::lock_guard Guard(Mutex);
+
+        Files.emplace_back(File);
+    }
+
+    void WorkingSetGovernor::Replace(MmioFile* Old, MmioFile* New)
+    {
+        std::lock_guard Guard(Mutex);
+
+        std::replace(Files.begin(), Files.end(), Old, New);
+        std::erase_if(Granules, [Old](const auto& Entry) {
+            return Entry.first.first == Old;
+        });
+    }
+
+    void WorkingSetGovernor::Unregister(MmioFile* File)
+    {
+        std::lock_guard Guard(Mutex);
+
+        std::erase(Files, File);
+        std::erase_if(Granules, [File](const auto& Entry) {
+            return Entry.first.first == File;
+        });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+namespace EGL3::Utils::Mmio {
+    class MmioFile;
+
+    // Keeps the pages of every open mapping that are in the working set under a budget
+    // Each sample looks at the process' working set, and the mapped ranges that haven't gained pages
+    // the longest are trimmed first
+    class WorkingSetGovernor {
+    public:
+        struct Stats {
+            uint64_t BudgetBytes;
+            uint64_t ResidentBytes;
+            uint64_t TrimmedBytes;
+        };
+
+        static WorkingSetGovernor& Get();
+
+        void SetBudget(uint64_t Bytes);
+
+        // Samples residency and trims anything over budget, meant to be called periodically
+        void Enforce();
+
+        Stats GetStats() const;
+
+    private:
+        friend class MmioFile;
+
+        WorkingSetGovernor();
+
+        void Register(MmioFile* File);
+
+        void Replace(MmioFile* Old, MmioFile* New);
+
+        void Unregister(MmioFile* File);
+
+        // Granules are the unit that residency is tracked and trimmed in
+        static constexpr size_t GranuleSize = 1ull << 24; // 16 mb
+
+        struct Granule {
+            uint32_t ResidentPages;
+            // Last sample the granule gained pages in
+            uint64_t LastActive;
+        };
+
+        mutable std::mutex Mutex;
+        std::vector<MmioFile*> Files;
+        std::map<std::pair<MmioFile*, size_t>, Granule> Granules;
+        std::vector<uintptr_t> WorkingSetBuffer;
+        uint64_t Tick;
+
+        uint64_t BudgetBytes;
+        uint64_t ResidentBytes;
+        uint64_t TrimmedBytes;
+    };
+}
\ No newline at end of file
@@ -13,7 +13,7 @@ namespace EGL3::Utils::Streams {
 
         Stream& write(const char* Buf, size_t BufCount) override {
             if (Position + BufCount > Size) {
-                BufCount = Size - Position;
+                BufCount = Position < Size ? Size - Position : 0;
             }
             memcpy(Buffer + Position, Buf, BufCount);
             Position += BufCount;
@@ -22,7 +22,7 @@ namespace EGL3::Utils::Streams {
 
         Stream& read(char* Buf, size_t BufCount) override {
             if (Position + BufCount > Size) {
-                BufCount = Size - Position;
+                BufCount = Position < Size ? Size - Position : 0;
             }
             memcpy(Buf, Buffer + Position, BufCount);
             Position += BufCount;
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "CompiledToken.h"
+
+#include <string>
+#include <vector>
+
+namespace EGL3::Utils::StringEx {
+    // A lexed, compiled and constant folded expression, stored as a flat postfix
+    // token list that can be evaluated any number of times without reparsing
+    class CompiledExpression {
+    public:
+        CompiledExpression(const std::string& Expression) :
+            Expression(Expression),
+            MaxStackDepth(0)
+        {
+
+        }
+
+        CompiledExpression(const CompiledExpression&) = delete;
+        CompiledExpression& operator=(const CompiledExpression&) = delete;
+
+        // Every StringToken in Tokens points into this string
+        const std::string& GetExpression() const {
+            return Expression;
+        }
+
+        const std::vector<CompiledToken>& GetTokens() const {
+            return Tokens;
+        }
+
+        size_t GetMaxStackDepth() const {
+            return MaxStackDepth;
+        }
+
+    private:
+        friend class ExpressionEvaluator;
+
+        const std::string Expression;
+        std::vector<CompiledToken> Tokens;
+        size_t MaxStackDepth;
+    };
+}
@@ -3,8 +3,7 @@
 #include "ExpressionCompiler.h"
 #include "Operators.h"
 
-#include <regex>
-#include <stack>
+#include <algorithm>
 
 namespace EGL3::Utils::StringEx {
     ExpressionEvaluator::ExpressionEvaluator()
@@ -83,34 +82,82 @@ namespace EGL3::Utils::StringEx {
             JumpTable.MapPreUnaryFull<FuncRegexGroupString, std::string>();
             JumpTable.MapPreUnaryFull<FuncCustom, FuncCustomData>();
         }
+
+        {
+            DefineContextualOperator<FuncRegex>();
+            DefineContextualOperator<FuncRegexGroupInt64>();
+            DefineContextualOperator<FuncRegexGroupString>();
+            DefineContextualOperator<FuncCustom>();
+        }
     }
 
     void ExpressionEvaluator::AddFunction(const std::string& Name, const std::function<std::any(const std::string&)> Func)
     {
         Functions.emplace(Name, Func);
+        // Custom functions change how expressions are lexed
+        ClearCache();
     }
 
     void ExpressionEvaluator::RemoveFunction(const std::string& Name)
     {
         Functions.erase(Name);
+        ClearCache();
     }
 
-    ExpressionError ExpressionEvaluator::Evaluate(const std::string& Expression, const std::string& Input, bool& Output) const
+    ExpressionError ExpressionEvaluator::Compile(const std::string& Expression, std::shared_ptr<const CompiledExpression>& Output) const
     {
+        {
+            std::lock_guard Guard(CacheMutex);
+            auto Itr = CacheLookup.find(Expression);
+            if (Itr != CacheLookup.end()) {
+                CacheLru.splice(CacheLru.begin(), CacheLru, Itr->second);
+                Output = Itr->second->second;
+                return ExpressionError();
+            }
+        }
+
+        // Tokens reference the expression's text, so the compiled expression lexes its own copy
+        auto Compiled = std::make_shared<CompiledExpression>(Expression);
+
         std::vector<ExpressionToken> LexedTokens;
-        auto Error = TokenDefinitions.Lex(Expression, LexedTokens);
+        auto Error = TokenDefinitions.Lex(Compiled->Expression, LexedTokens);
         if (Error.HasError()) {
             return Error;
         }
 
-        std::vector<CompiledToken> CompiledTokens;
-        Error = ExpressionCompiler(Grammar, LexedTokens, CompiledTokens);
+        Error = ExpressionCompiler(Grammar, LexedTokens, Compiled->Tokens);
         if (Error.HasError()) {
             return Error;
         }
 
+        FoldConstants(*Compiled);
+
+        {
+            std::lock_guard Guard(CacheMutex);
+            auto Itr = CacheLookup.find(Expression);
+            if (Itr != CacheLookup.end()) {
+                // Another thread compiled it first
+                CacheLru.splice(CacheLru.begin(), CacheLru, Itr->second);
+                Output = Itr->second->second;
+                return ExpressionError();
+            }
+
+            CacheLru.emplace_front(Expression, Compiled);
+            CacheLookup.emplace(Expression, CacheLru.begin());
+            if (CacheLru.size() > CacheCapacity) {
+                CacheLookup.erase(CacheLru.back().first);
+                CacheLru.pop_back();
+            }
+        }
+
+        Output = std::move(Compiled);
+        return ExpressionError();
+    }
+
+    ExpressionError ExpressionEvaluator::Evaluate(const CompiledExpression& Expression, const std::string& Input, bool& Output) const
+    {
         std::any Result;
-        Error = Evaluate(CompiledTokens, ExpressionContext(Expression, Input, Functions), Result);
+        auto Error = Evaluate(Expression, ExpressionContext(Expression.GetExpression(), Input, Functions), Result);
         if (Error.HasError()) {
             return Error;
         }
@@ -125,6 +172,26 @@ namespace EGL3::Utils::StringEx {
         }
     }
 
+    ExpressionError ExpressionEvaluator::Evaluate(const std::string& Expression, const std::string& Input, bool& Output) const
+    {
+        std::shared_ptr<const CompiledExpression> Compiled;
+        auto Error = Compile(Expression, Compiled);
+        if (Error.HasError()) {
+            return Error;
+        }
+
+        return Evaluate(*Compiled, Input, Output);
+    }
+
+    bool ExpressionEvaluator::Evaluate(const CompiledExpression& Expression, const std::string& Input) const
+    {
+        bool Output;
+        if (Evaluate(Expression, Input, Output).HasError()) {
+            return false;
+        }
+        return Output;
+    }
+
     bool ExpressionEvaluator::Evaluate(const std::string& Expression, const std::string& Input) const
     {
         bool Output;
@@ -134,55 +201,157 @@ namespace EGL3::Utils::StringEx {
         return Output;
     }
 
-    ExpressionError ExpressionEvaluator::Evaluate(const std::vector<CompiledToken>& CompiledTokens, const ExpressionContext& Ctx, std::any& Output) const
+    void ExpressionEvaluator::FoldConstants(CompiledExpression& Expression) const
     {
-        std::vector<ExpressionToken> RuntimeGeneratedTokens;
-        std::stack<size_t> OperandStack;
+        auto& Tokens = Expression.Tokens;
 
-        auto GetToken = [&](size_t Index) -> const ExpressionToken& {
-            if (Index < CompiledTokens.size()) {
-                return CompiledTokens[Index];
-            }
+        // Short circuit tokens store absolute indices, don't try to fold around them
+        if (std::any_of(Tokens.begin(), Tokens.end(), [](const CompiledToken& Token) { return Token.Type == TokenType::ShortCircuit; })) {
+            Expression.MaxStackDepth = Tokens.size();
+            return;
+        }
 
-            return RuntimeGeneratedTokens[Index - CompiledTokens.size()];
-        };
+        // Functions aren't available when folding, but only contextual operators use them anyway
+        static const std::string EmptyString;
+        static const std::unordered_map<std::string, std::function<std::any(const std::string&)>> EmptyFunctions;
+        ExpressionContext FoldCtx(Expression.Expression, EmptyString, EmptyFunctions);
 
-        auto AddToken = [&](ExpressionToken&& In) -> size_t {
-            auto Index = CompiledTokens.size() + RuntimeGeneratedTokens.size();
-            RuntimeGeneratedTokens.emplace_back(std::move(In));
-            return Index;
+        // Each operand on the stack spans from its start index to the end of Folded
+        struct Operand {
+            size_t Start;
+            bool IsConstant;
         };
 
-        for (size_t Idx = 0; Idx < CompiledTokens.size(); ++Idx) {
-            auto& Token = CompiledTokens[Idx];
+        std::vector<CompiledToken> Folded;
+        Folded.reserve(Tokens.size());
+        std::vector<Operand> OperandStack;
+        size_t MaxStackDepth = 0;
 
+        for (auto& Token : Tokens) {
             switch (Token.Type)
             {
             case TokenType::Benign:
+                Folded.emplace_back(Token);
                 continue;
             case TokenType::Operand:
-                OperandStack.emplace(Idx);
+                OperandStack.push_back({ Folded.size(), true });
+                MaxStackDepth = std::max(MaxStackDepth, OperandStack.size());
+                Folded.emplace_back(Token);
+                continue;
+            case TokenType::BinaryOperator:
+            {
+                if (OperandStack.size() < 2) {
+                    // Malformed, let the evaluator report the error
+                    Expression.MaxStackDepth = Tokens.size();
+                    return;
+                }
+
+                auto R = OperandStack.back();
+                OperandStack.pop_back();
+                auto L = OperandStack.back();
+                OperandStack.pop_back();
+
+                if (L.IsConstant && R.IsConstant && !ContextualOperators.contains(Token.Node.type())) {
+                    // Constant operands are always a single folded token
+                    std::any OpResult;
+                    if (!JumpTable.ExecBinary(Token.Node.type(), Folded[L.Start].Node, Folded[R.Start].Node, &FoldCtx, OpResult).HasError()) {
+                        ExpressionToken Result(Folded[L.Start].Token, std::move(OpResult));
+                        Folded.erase(Folded.begin() + L.Start, Folded.end());
+                        Folded.emplace_back(TokenType::Operand, Result);
+                        OperandStack.push_back({ L.Start, true });
+                        continue;
+                    }
+                }
+
+                Folded.emplace_back(Token);
+                OperandStack.push_back({ L.Start, false });
+                continue;
+            }
+            case TokenType::PostUnaryOperator:
+            case TokenType::PreUnaryOperator:
+            {
+                if (OperandStack.empty()) {
+                    Expression.MaxStackDepth = Tokens.size();
+                    return;
+                }
+
+                auto V = OperandStack.back();
+                OperandStack.pop_back();
+
+                if (V.IsConstant && !ContextualOperators.contains(Token.Node.type())) {
+                    std::any OpResult;
+                    ExpressionError OpError = (Token.Type == TokenType::PreUnaryOperator) ?
+                        JumpTable.ExecPreUnary(Token.Node.type(), Folded[V.Start].Node, &FoldCtx, OpResult) :
+                        JumpTable.ExecPostUnary(Token.Node.type(), Folded[V.Start].Node, &FoldCtx, OpResult);
+                    if (!OpError.HasError()) {
+                        ExpressionToken Result(Folded[V.Start].Token, std::move(OpResult));
+                        Folded.erase(Folded.begin() + V.Start, Folded.end());
+                        Folded.emplace_back(TokenType::Operand, Result);
+                        OperandStack.push_back({ V.Start, true });
+                        continue;
+                    }
+                }
+
+                Folded.emplace_back(Token);
+                OperandStack.push_back({ V.Start, false });
+                continue;
+            }
+            default:
+                Expression.MaxStackDepth = Tokens.size();
+                return;
+            }
+        }
+
+        Tokens = std::move(Folded);
+        Expression.MaxStackDepth = MaxStackDepth;
+    }
+
+    void ExpressionEvaluator::ClearCache()
+    {
+        std::lock_guard Guard(CacheMutex);
+        CacheLookup.clear();
+        CacheLru.clear();
+    }
+
+    ExpressionError ExpressionEvaluator::Evaluate(const CompiledExpression& Expression, const ExpressionContext& Ctx, std::any& Output) const
+    {
+        auto& Tokens = Expression.GetTokens();
+
+        // Operands point either into Tokens or into Temporaries. Each operator creates at most
+        // one temporary, so reserving the token count keeps those pointers stable.
+        std::vector<const std::any*> OperandStack;
+        OperandStack.reserve(Expression.GetMaxStackDepth());
+        std::vector<std::any> Temporaries;
+        Temporaries.reserve(Tokens.size());
+
+        for (size_t Idx = 0; Idx < Tokens.size(); ++Idx) {
+            auto& Token = Tokens[Idx];
+
+            switch (Token.Type)
+            {
+            case TokenType::Benign:
+                continue;
+            case TokenType::Operand:
+                OperandStack.emplace_back(&Token.Node);
                 continue;
             case TokenType::ShortCircuit:
-                if (!OperandStack.empty() && Token.ShortCircuitIdx == -1 && JumpTable.ShouldShortCircuit(Token, GetToken(OperandStack.top()), &Ctx)) {
+                // ShortCircuitIdx is only -1 if the compiler never patched in the index to jump to, there's nowhere to go then
+                if (!OperandStack.empty() && Token.ShortCircuitIdx != -1 && JumpTable.ShouldShortCircuit(Token.Node.type(), *OperandStack.back(), &Ctx)) {
                     Idx = Token.ShortCircuitIdx;
                 }
                 continue;
             case TokenType::BinaryOperator:
                 if (OperandStack.size() >= 2) {
-                    auto R = GetToken(OperandStack.top());
-                    OperandStack.pop();
-                    auto L = GetToken(OperandStack.top());
-                    OperandStack.pop();
+                    auto R = OperandStack.back();
+                    OperandStack.pop_back();
+                    auto L = OperandStack.back();
+                    OperandStack.pop_back();
 
-                    std::any OpResult;
-                    ExpressionError OpError = JumpTable.ExecBinary(Token, L, R, &Ctx, OpResult);
+                    ExpressionError OpError = JumpTable.ExecBinary(Token.Node.type(), *L, *R, &Ctx, Temporaries.emplace_back());
                     if (OpError.HasError()) {
                         return OpError;
                     }
-                    else {
-                        OperandStack.emplace(AddToken(ExpressionToken(L.Token, std::move(OpResult))));
-                    }
+                    OperandStack.emplace_back(&Temporaries.back());
                 }
                 else {
                     return ExpressionError("Not enough operands for binary operator");
@@ -191,20 +360,16 @@ namespace EGL3::Utils::StringEx {
             case TokenType::PostUnaryOperator:
             case TokenType::PreUnaryOperator:
                 if (OperandStack.size() >= 1) {
-                    auto Operand = GetToken(OperandStack.top());
-                    OperandStack.pop();
+                    auto Operand = OperandStack.back();
+                    OperandStack.pop_back();
 
-                    std::any OpResult;
                     ExpressionError OpError = (Token.Type == TokenType::PreUnaryOperator) ?
-                        JumpTable.ExecPreUnary(Token, Operand, &Ctx, OpResult) :
-                        JumpTable.ExecPostUnary(Token, Operand, &Ctx, OpResult);
-
+                        JumpTable.ExecPreUnary(Token.Node.type(), *Operand, &Ctx, Temporaries.emplace_back()) :
+                        JumpTable.ExecPostUnary(Token.Node.type(), *Operand, &Ctx, Temporaries.emplace_back());
                     if (OpError.HasError()) {
                         return OpError;
                     }
-                    else {
-                        OperandStack.emplace(AddToken(ExpressionToken(Operand.Token, std::move(OpResult))));
-                    }
+                    OperandStack.emplace_back(&Temporaries.back());
                 }
                 else {
                     return ExpressionError("No operand for unary operator");
@@ -214,7 +379,7 @@ namespace EGL3::Utils::StringEx {
         }
 
         if (OperandStack.size() == 1) {
-            Output = GetToken(OperandStack.top()).Node;
+            Output = *OperandStack.back();
             return ExpressionError();
         }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "CompiledExpression.h"
 #include "CompiledToken.h"
 #include "ExpressionError.h"
 #include "ExpressionGrammar.h"
@@ -8,8 +9,13 @@
 #include "ExpressionContext.h"
 
 #include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <typeindex>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace EGL3::Utils::StringEx {
     // Based off of https://github.com/EpicGames/UnrealEngine/blob/master/Engine/Source/Runtime/Core/Public/Math/BasicMathExpressionEvaluator.h
@@ -23,16 +29,41 @@ namespace EGL3::Utils::StringEx {
 
         void RemoveFunction(const std::string& Name);
 
+        // Compiled expressions are cached by their text, so calling this repeatedly with the same expression is cheap
+        ExpressionError Compile(const std::string& Expression, std::shared_ptr<const CompiledExpression>& Output) const;
+
+        ExpressionError Evaluate(const CompiledExpression& Expression, const std::string& Input, bool& Output) const;
+
         ExpressionError Evaluate(const std::string& Expression, const std::string& Input, bool& Output) const;
 
+        bool Evaluate(const CompiledExpression& Expression, const std::string& Input) const;
+
         bool Evaluate(const std::string& Expression, const std::string& Input) const;
 
     private:
-        ExpressionError Evaluate(const std::vector<CompiledToken>& CompiledTokens, const ExpressionContext& Ctx, std::any& Output) const;
+        static constexpr size_t CacheCapacity = 256;
+
+        template<typename TOperator>
+        void DefineContextualOperator() {
+            ContextualOperators.emplace(typeid(TOperator));
+        }
+
+        void FoldConstants(CompiledExpression& Expression) const;
+
+        void ClearCache();
+
+        ExpressionError Evaluate(const CompiledExpression& Expression, const ExpressionContext& Ctx, std::any& Output) const;
 
         TokenDefinitions TokenDefinitions;
         ExpressionGrammar Grammar;
         JumpTable<ExpressionContext> JumpTable;
         std::unordered_map<std::string, std::function<std::any(const std::string&)>> Functions;
+        // Operators whose result depends on the input or external state, and can't be folded at compile time
+        std::unordered_set<std::type_index> ContextualOperators;
+
+        using CacheList = std::list<std::pair<std::string, std::shared_ptr<const CompiledExpression>>>;
+        mutable std::mutex CacheMutex;
+        mutable CacheList CacheLru;
+        mutable std::unordered_map<std::string, CacheList::iterator> CacheLookup;
     };
 }
\ No newline at end of file
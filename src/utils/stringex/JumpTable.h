@@ -5,6 +5,8 @@
 #include "OperatorFunctionId.h"
 
 #include <functional>
+#include <typeindex>
+#include <unordered_map>
 
 namespace EGL3::Utils::StringEx {
     template<class T>
@@ -15,36 +17,52 @@ namespace EGL3::Utils::StringEx {
         using ShortCircuit = std::function<bool(const std::any&, const T*)>;
 
         ExpressionError ExecPreUnary(const ExpressionToken& Operator, const ExpressionToken& R, const T* Ctx, std::any& Output) const {
-            auto Itr = PreUnaryOps.find(OperatorFunctionId{ Operator.Node.type(), typeid(void), R.Node.type() });
+            return ExecPreUnary(Operator.Node.type(), R.Node, Ctx, Output);
+        }
+
+        ExpressionError ExecPreUnary(const std::type_index& Operator, const std::any& R, const T* Ctx, std::any& Output) const {
+            auto Itr = PreUnaryOps.find(OperatorFunctionId{ Operator, typeid(void), R.type() });
             if (Itr != PreUnaryOps.end()) {
-                return Itr->second(R.Node, Ctx, Output);
+                return Itr->second(R, Ctx, Output);
             }
 
             return ExpressionError("Preunary operator cannot operate on such types");
         }
         
         ExpressionError ExecPostUnary(const ExpressionToken& Operator, const ExpressionToken& L, const T* Ctx, std::any& Output) const {
-            auto Itr = PostUnaryOps.find(OperatorFunctionId{ Operator.Node.type(), L.Node.type(), typeid(void) });
+            return ExecPostUnary(Operator.Node.type(), L.Node, Ctx, Output);
+        }
+
+        ExpressionError ExecPostUnary(const std::type_index& Operator, const std::any& L, const T* Ctx, std::any& Output) const {
+            auto Itr = PostUnaryOps.find(OperatorFunctionId{ Operator, L.type(), typeid(void) });
             if (Itr != PostUnaryOps.end()) {
-                return Itr->second(L.Node, Ctx, Output);
+                return Itr->second(L, Ctx, Output);
             }
 
             return ExpressionError("Postunary operator cannot operate on such types");
         }
 
         ExpressionError ExecBinary(const ExpressionToken& Operator, const ExpressionToken& L, const ExpressionToken& R, const T* Ctx, std::any& Output) const {
-            auto Itr = BinaryOps.find(OperatorFunctionId{ Operator.Node.type(), L.Node.type(), R.Node.type() });
+            return ExecBinary(Operator.Node.type(), L.Node, R.Node, Ctx, Output);
+        }
+
+        ExpressionError ExecBinary(const std::type_index& Operator, const std::any& L, const std::any& R, const T* Ctx, std::any& Output) const {
+            auto Itr = BinaryOps.find(OperatorFunctionId{ Operator, L.type(), R.type() });
             if (Itr != BinaryOps.end()) {
-                return Itr->second(L.Node, R.Node, Ctx, Output);
+                return Itr->second(L, R, Ctx, Output);
             }
 
             return ExpressionError("Binary operator cannot operate on such types");
         }
 
         bool ShouldShortCircuit(const ExpressionToken& Operator, const ExpressionToken& L, const T* Ctx) const {
-            auto Itr = BinaryShortCircuits.find(OperatorFunctionId{ Operator.Node.type(), L.Node.type(), typeid(void) });
+            return ShouldShortCircuit(Operator.Node.type(), L.Node, Ctx);
+        }
+
+        bool ShouldShortCircuit(const std::type_index& Operator, const std::any& L, const T* Ctx) const {
+            auto Itr = BinaryShortCircuits.find(OperatorFunctionId{ Operator, L.type(), typeid(void) });
             if (Itr != BinaryShortCircuits.end()) {
-                return Itr->second(L.Node, Ctx);
+                return Itr->second(L, Ctx);
             }
 
             return false;
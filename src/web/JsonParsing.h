@@ -8,6 +8,7 @@
 #include <chrono>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <rapidjson/document.h>
 #include <vector>
 #include <unordered_map>
@@ -52,12 +53,64 @@ namespace EGL3::Web {
 
     // Make sure to check validity with Json.HasParseError()
     // Use something similar to printf("%d @ %zu\n", Json.GetParseError(), Json.GetErrorOffset());
-    static rapidjson::Document ParseJson(const std::string& Data) {
+    static rapidjson::Document ParseJson(std::string_view Data) {
         rapidjson::Document Json;
         Json.Parse(Data.data(), Data.size());
         return Json;
     }
 
+    // Looks up object members starting right after the last member that was found.
+    // Parse functions tend to declare their items in the same order that the
+    // response has them, so most lookups only compare a single member instead
+    // of scanning the whole object each time like FindMember does.
+    class JsonMemberFinder {
+    public:
+        using Iterator = rapidjson::Value::ConstMemberIterator;
+
+        // Anything that isn't an object (PARSE_ITEM_ROOT types are usually arrays) has no members to find
+        JsonMemberFinder(const rapidjson::Value& Json) :
+            Begin(Json.IsObject() ? Json.MemberBegin() : Iterator()),
+            End(Json.IsObject() ? Json.MemberEnd() : Iterator()),
+            Hint(Begin)
+        {
+
+        }
+
+        template<size_t NameSize>
+        __forceinline Iterator Find(const char(&Name)[NameSize]) {
+            return Find(Name, NameSize - 1);
+        }
+
+        Iterator Find(const char* Name, size_t NameSize) {
+            for (auto Itr = Hint; Itr != End; ++Itr) {
+                if (Matches(*Itr, Name, NameSize)) {
+                    Hint = Itr + 1;
+                    return Itr;
+                }
+            }
+            for (auto Itr = Begin; Itr != Hint; ++Itr) {
+                if (Matches(*Itr, Name, NameSize)) {
+                    Hint = Itr + 1;
+                    return Itr;
+                }
+            }
+            return End;
+        }
+
+        Iterator GetEnd() const {
+            return End;
+        }
+
+    private:
+        static __forceinline bool Matches(const rapidjson::Value::Member& Member, const char* Name, size_t NameSize) {
+            return Member.name.GetStringLength() == NameSize && memcmp(Member.name.GetString(), Name, NameSize) == 0;
+        }
+
+        Iterator Begin;
+        Iterator End;
+        Iterator Hint;
+    };
+
     template<typename T>
     struct Parser {
         __forceinline bool operator()(const rapidjson::Value& Json, T& Obj) const {
@@ -302,6 +355,7 @@ typedef JsonEnum<ClassName, ClassName##Converter<>> ClassName##Json;
 
 #define PARSE_DEFINE(ClassName) \
     static bool Parse(const ::rapidjson::Value& Json, ClassName& Obj) { \
+        ::EGL3::Web::JsonMemberFinder Members(Json); \
         ::rapidjson::Document::ConstMemberIterator Itr;
 
 #define PARSE_END \
@@ -312,17 +366,17 @@ typedef JsonEnum<ClassName, ClassName##Converter<>> ClassName##Json;
         if (!BaseClass::Parse(Json, Obj)) { PRINT_JSON_ERROR_PARSE; return false; }
 
 #define PARSE_ITEM(JsonName, TargetVariable) \
-        Itr = Json.FindMember(JsonName); \
-        if (Itr == Json.MemberEnd()) { PRINT_JSON_ERROR_NOTFOUND; return false; } \
+        Itr = Members.Find(JsonName); \
+        if (Itr == Members.GetEnd()) { PRINT_JSON_ERROR_NOTFOUND; return false; } \
         if (!::EGL3::Web::Parser<decltype(Obj.TargetVariable)>{}(Itr->value, Obj.TargetVariable)) { PRINT_JSON_ERROR_PARSE; return false; }
 
 #define PARSE_ITEM_OPT(JsonName, TargetVariable) \
-        Itr = Json.FindMember(JsonName); \
-        if (Itr != Json.MemberEnd()) { if (!::EGL3::Web::Parser<decltype(Obj.TargetVariable)>{}(Itr->value, Obj.TargetVariable)) { PRINT_JSON_ERROR_PARSE; return false; } }
+        Itr = Members.Find(JsonName); \
+        if (Itr != Members.GetEnd()) { if (!::EGL3::Web::Parser<decltype(Obj.TargetVariable)>{}(Itr->value, Obj.TargetVariable)) { PRINT_JSON_ERROR_PARSE; return false; } }
 
 #define PARSE_ITEM_DEF(JsonName, TargetVariable, Default) \
-        Itr = Json.FindMember(JsonName); \
-        if (Itr != Json.MemberEnd()) { if (!::EGL3::Web::Parser<decltype(Obj.TargetVariable)>{}(Itr->value, Obj.TargetVariable)) { Obj.TargetVariable = Default; } }
+        Itr = Members.Find(JsonName); \
+        if (Itr != Members.GetEnd()) { if (!::EGL3::Web::Parser<decltype(Obj.TargetVariable)>{}(Itr->value, Obj.TargetVariable)) { Obj.TargetVariable = Default; } }
 
 #define PARSE_ITEM_LOC(JsonName, TargetVariable) \
         if (!::EGL3::Web::JsonLocalized::Parse(Json, Obj.TargetVariable, JsonName)) { PRINT_JSON_ERROR_PARSE; return false; }
@@ -123,19 +123,35 @@ namespace EGL3::Web::Epic {
         return BPS::Manifest(Response.text.data(), Response.text.size());
     }
 
-    cpr::Response GetChunkData(const std::string& CloudDir, BPS::FeatureLevel FeatureLevel, const BPS::ChunkInfo& ChunkInfo)
+    // Cloud dirs like file://D:/Mirror/CloudDir point to a local copy with the same layout as the CDN
+    static constexpr std::string_view LocalCloudDirPrefix = "file://";
+
+    std::string GetChunkUrl(const std::string& CloudDir, BPS::FeatureLevel FeatureLevel, const BPS::ChunkInfo& ChunkInfo)
     {
-        return Http::Get(
-            cpr::Url{ std::format("{}/{}/{:02}/{:016X}_{:08X}{:08X}{:08X}{:08X}.chunk",
-                CloudDir.c_str(),
-                BPS::GetChunkSubdir(FeatureLevel),
-                ChunkInfo.GroupNumber,
-                ChunkInfo.Hash,
-                ChunkInfo.Guid.A, ChunkInfo.Guid.B, ChunkInfo.Guid.C, ChunkInfo.Guid.D
-            ) }
+        return std::format("{}/{}/{:02}/{:016X}_{:08X}{:08X}{:08X}{:08X}.chunk",
+            CloudDir.c_str(),
+            BPS::GetChunkSubdir(FeatureLevel),
+            ChunkInfo.GroupNumber,
+            ChunkInfo.Hash,
+            ChunkInfo.Guid.A, ChunkInfo.Guid.B, ChunkInfo.Guid.C, ChunkInfo.Guid.D
         );
     }
 
+    cpr::Response GetChunkData(const std::string& CloudDir, BPS::FeatureLevel FeatureLevel, const BPS::ChunkInfo& ChunkInfo)
+    {
+        return Http::Get(cpr::Url{ GetChunkUrl(CloudDir, FeatureLevel, ChunkInfo) });
+    }
+
+    Response<BPS::ChunkData> GetLocalChunk(const std::string& CloudDir, BPS::FeatureLevel FeatureLevel, const BPS::ChunkInfo& ChunkInfo)
+    {
+        Utils::Streams::FileStream Stream;
+        if (!Stream.open(GetChunkUrl(CloudDir, FeatureLevel, ChunkInfo).substr(LocalCloudDirPrefix.size()), "rb")) {
+            return 404;
+        }
+
+        return BPS::ChunkData(Stream);
+    }
+
     Response<BPS::ChunkData> EpicClient::GetChunk(const std::string& CloudDir, BPS::FeatureLevel FeatureLevel, const BPS::ChunkInfo& ChunkInfo)
     {
         RunningFunctionGuard Guard(Lock);
@@ -148,6 +164,10 @@ namespace EGL3::Web::Epic {
             return 400;
         }
 
+        if (CloudDir.starts_with(LocalCloudDirPrefix)) {
+            return GetLocalChunk(CloudDir, FeatureLevel, ChunkInfo);
+        }
+
         auto Response = GetChunkData(CloudDir, FeatureLevel, ChunkInfo);
 
         if (GetCancelled()) { return ErrorData::Status::Cancelled; }
@@ -171,6 +191,11 @@ namespace EGL3::Web::Epic {
             return 400;
         }
 
+        // Already on disk, there's nothing to cache
+        if (CloudDir.starts_with(LocalCloudDirPrefix)) {
+            return GetLocalChunk(CloudDir, FeatureLevel, ChunkInfo);
+        }
+
         auto CachedPath = (CacheDir / std::format("{:08X}{:08X}{:08X}{:08X}", ChunkInfo.Guid.A, ChunkInfo.Guid.B, ChunkInfo.Guid.C, ChunkInfo.Guid.D)).replace_extension("chunk");
         std::error_code Error;
         if (std::filesystem::is_regular_file(CachedPath, Error)) {
@@ -71,6 +71,12 @@ namespace EGL3::Web::Epic::BPS {
             return Stream;
         }
 
+        // Sizes come straight from the data, check them before anything is allocated from them
+        if (Val.Header.IsCompressed() ? Val.Header.DataSizeUncompressed > (uint64_t)Val.Header.DataSizeCompressed * Utils::Compressor<Utils::CompressionMethod::Zlib>::MaxRatio : Val.Header.DataSizeUncompressed != Val.Header.DataSizeCompressed) {
+            Val.SetError(ChunkData::ErrorType::IncorrectFileSize);
+            return Stream;
+        }
+
         // Read data
         Val.Data = std::make_unique<char[]>(Val.Header.DataSizeCompressed);
         Stream.read(Val.Data.get(), Val.Header.DataSizeCompressed);
@@ -15,6 +15,10 @@ namespace EGL3::Web::Epic::BPS {
             Stream >> ElementCount;
         }
 
+        if (!Stream.IsCountValid(ElementCount)) {
+            return Stream;
+        }
+
         Val.ChunkList.resize(ElementCount);
 
         if (DataVersion >= ChunkDataListVersion::Original) {
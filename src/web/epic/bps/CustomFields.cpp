@@ -15,6 +15,10 @@ namespace EGL3::Web::Epic::BPS {
             Stream >> ElementCount;
         }
 
+        if (!Stream.IsCountValid(ElementCount)) {
+            return Stream;
+        }
+
         std::vector<std::pair<std::string, std::string>> FieldList;
         FieldList.resize(ElementCount);
 
@@ -16,6 +16,10 @@ namespace EGL3::Web::Epic::BPS {
             Stream >> ElementCount;
         }
 
+        if (!Stream.IsCountValid(ElementCount)) {
+            return Stream;
+        }
+
         Val.FileList.resize(ElementCount);
 
         if (DataVersion >= FileManifestListVersion::Original) {
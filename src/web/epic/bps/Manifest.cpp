@@ -4,10 +4,10 @@
 #include "../../../utils/Compression.h"
 #include "../../../utils/Crc32.h"
 #include "../../../utils/Hex.h"
-#include "../../../utils/JsonWrapperStream.h"
 #include "../../../utils/SHA.h"
 #include "../../../utils/streams/BufferStream.h"
 #include "../../../utils/StringBlob.h"
+#include "../../JsonParsing.h"
 #include "UEStream.h"
 
 #include <algorithm>
@@ -30,7 +30,8 @@ namespace EGL3::Web::Epic::BPS {
         Stream >> *this;
     }
 
-    Manifest::Manifest(const rapidjson::Document& Json)
+    Manifest::Manifest(const rapidjson::Document& Json) :
+        Error(ErrorType::Success)
     {
         ReadFromJson(Json);
     }
@@ -77,9 +78,9 @@ namespace EGL3::Web::Epic::BPS {
         return true;
     }
 
-    bool TryGetString(const rapidjson::Value& Json, const char* Name, std::string& Out) {
-        auto Val = Json.FindMember(Name);
-        if (Val == Json.MemberEnd()) {
+    bool TryGetString(JsonMemberFinder& Members, const char* Name, std::string& Out) {
+        auto Val = Members.Find(Name, strlen(Name));
+        if (Val == Members.GetEnd()) {
             return false;
         }
         return TryGetString(Val->value, Out);
@@ -95,9 +96,9 @@ namespace EGL3::Web::Epic::BPS {
     }
 
     template<class T>
-    bool TryGetStringBlob(const rapidjson::Value& Json, const char* Name, T& Out) {
-        auto Val = Json.FindMember(Name);
-        if (Val == Json.MemberEnd()) {
+    bool TryGetStringBlob(JsonMemberFinder& Members, const char* Name, T& Out) {
+        auto Val = Members.Find(Name, strlen(Name));
+        if (Val == Members.GetEnd()) {
             return false;
         }
         return TryGetStringBlob(Val->value, Out);
@@ -112,15 +113,6 @@ namespace EGL3::Web::Epic::BPS {
         return true;
     }
 
-    template<uint32_t OutSize>
-    bool TryGetHex(const rapidjson::Value& Json, const char* Name, char(&Out)[OutSize]) {
-        auto Val = Json.FindMember(Name);
-        if (Val == Json.MemberEnd()) {
-            return false;
-        }
-        return TryGetHex(Val->value, Out);
-    }
-
     template<class T>
     bool TryGet(const rapidjson::Value& Val, T& Out) {
         if (!Val.Is<T>()) {
@@ -131,9 +123,9 @@ namespace EGL3::Web::Epic::BPS {
     }
 
     template<class T>
-    bool TryGet(const rapidjson::Value& Json, const char* Name, T& Out) {
-        auto Val = Json.FindMember(Name);
-        if (Val == Json.MemberEnd()) {
+    bool TryGet(JsonMemberFinder& Members, const char* Name, T& Out) {
+        auto Val = Members.Find(Name, strlen(Name));
+        if (Val == Members.GetEnd()) {
             return false;
         }
         return TryGet<T>(Val->value, Out);
@@ -179,9 +171,9 @@ namespace EGL3::Web::Epic::BPS {
         return true;
     }
 
-    bool TryGetGuid(const rapidjson::Value& Json, const char* Name, Utils::Guid& Out) {
-        auto Val = Json.FindMember(Name);
-        if (Val == Json.MemberEnd()) {
+    bool TryGetGuid(JsonMemberFinder& Members, const char* Name, Utils::Guid& Out) {
+        auto Val = Members.Find(Name, strlen(Name));
+        if (Val == Members.GetEnd()) {
             return false;
         }
         return TryGetGuid(Val->value, Out);
@@ -195,84 +187,88 @@ namespace EGL3::Web::Epic::BPS {
             return;
         }
 
-        if (!TryGetStringBlob(Json, "ManifestFileVersion", ManifestMeta.FeatureLevel)) {
+        JsonMemberFinder Members(Json);
+
+        if (!TryGetStringBlob(Members, "ManifestFileVersion", ManifestMeta.FeatureLevel)) {
             ManifestMeta.FeatureLevel = BPS::FeatureLevel::CustomFields;
         }
         if (ManifestMeta.FeatureLevel == BPS::FeatureLevel::BrokenJsonVersion) {
             ManifestMeta.FeatureLevel = BPS::FeatureLevel::StoresChunkFileSizes;
         }
 
-        if (!TryGetStringBlob(Json, "AppID", ManifestMeta.AppId)) {
+        if (!TryGetStringBlob(Members, "AppID", ManifestMeta.AppId)) {
             SetError(ErrorType::BadJson);
             return;
         }
 
-        if (!TryGetString(Json, "AppNameString", ManifestMeta.AppName)) {
+        if (!TryGetString(Members, "AppNameString", ManifestMeta.AppName)) {
             SetError(ErrorType::BadJson);
             return;
         }
 
-        if (!TryGetString(Json, "BuildVersionString", ManifestMeta.BuildVersion)) {
+        if (!TryGetString(Members, "BuildVersionString", ManifestMeta.BuildVersion)) {
             SetError(ErrorType::BadJson);
             return;
         }
 
-        if (!TryGetString(Json, "LaunchExeString", ManifestMeta.LaunchExe)) {
+        if (!TryGetString(Members, "LaunchExeString", ManifestMeta.LaunchExe)) {
             SetError(ErrorType::BadJson);
             return;
         }
 
-        if (!TryGetString(Json, "LaunchCommand", ManifestMeta.LaunchCommand)) {
+        if (!TryGetString(Members, "LaunchCommand", ManifestMeta.LaunchCommand)) {
             SetError(ErrorType::BadJson);
             return;
         }
 
         // Optional
-        TryGetString(Json, "PrereqName", ManifestMeta.PrereqName);
-        TryGetString(Json, "PrereqPath", ManifestMeta.PrereqPath);
-        TryGetString(Json, "PrereqArgs", ManifestMeta.PrereqArgs);
+        TryGetString(Members, "PrereqName", ManifestMeta.PrereqName);
+        TryGetString(Members, "PrereqPath", ManifestMeta.PrereqPath);
+        TryGetString(Members, "PrereqArgs", ManifestMeta.PrereqArgs);
 
         std::unordered_map<Utils::Guid, ChunkInfo> ChunkMap;
 
-        auto JsonFileManifestList = Json.FindMember("FileManifestList");
-        if (JsonFileManifestList == Json.MemberEnd() || !JsonFileManifestList->value.IsArray()) {
+        auto JsonFileManifestList = Members.Find("FileManifestList");
+        if (JsonFileManifestList == Members.GetEnd() || !JsonFileManifestList->value.IsArray()) {
             SetError(ErrorType::BadJson);
             return;
         }
         FileManifestList.FileList.reserve(JsonFileManifestList->value.GetArray().Size());
         for (auto& JsonFileManifest : JsonFileManifestList->value.GetArray()) {
             auto& FileManifest = FileManifestList.FileList.emplace_back();
+            JsonMemberFinder FileMembers(JsonFileManifest);
 
-            if (!TryGetString(JsonFileManifest, "Filename", FileManifest.Filename)) {
+            if (!TryGetString(FileMembers, "Filename", FileManifest.Filename)) {
                 SetError(ErrorType::BadJson);
                 return;
             }
 
-            if (!TryGetStringBlob(JsonFileManifest, "FileHash", FileManifest.FileHash)) {
+            if (!TryGetStringBlob(FileMembers, "FileHash", FileManifest.FileHash)) {
                 SetError(ErrorType::BadJson);
                 return;
             }
 
-            auto JsonChunkParts = JsonFileManifest.FindMember("FileChunkParts");
-            if (JsonChunkParts == JsonFileManifest.MemberEnd() || !JsonChunkParts->value.IsArray()) {
+            auto JsonChunkParts = FileMembers.Find("FileChunkParts");
+            if (JsonChunkParts == FileMembers.GetEnd() || !JsonChunkParts->value.IsArray()) {
                 SetError(ErrorType::BadJson);
                 return;
             }
             FileManifest.ChunkParts.reserve(JsonChunkParts->value.GetArray().Size());
             for (auto& JsonChunkPart : JsonChunkParts->value.GetArray()) {
                 auto& ChunkPart = FileManifest.ChunkParts.emplace_back();
+                JsonMemberFinder PartMembers(JsonChunkPart);
 
-                if (!TryGetGuid(JsonChunkPart, "Guid", ChunkPart.Guid)) {
+                if (!TryGetGuid(PartMembers, "Guid", ChunkPart.Guid)) {
                     SetError(ErrorType::BadJson);
                     return;
                 }
 
-                if (!TryGetStringBlob(JsonChunkPart, "Offset", ChunkPart.Offset)) {
+                if (!TryGetStringBlob(PartMembers, "Offset", ChunkPart.Offset)) {
                     SetError(ErrorType::BadJson);
                     return;
                 }
 
-                if (!TryGetStringBlob(JsonChunkPart, "Size", ChunkPart.Size)) {
+                if (!TryGetStringBlob(PartMembers, "Size", ChunkPart.Size)) {
                     SetError(ErrorType::BadJson);
                     return;
                 }
@@ -280,8 +276,8 @@ namespace EGL3::Web::Epic::BPS {
                 ChunkMap.try_emplace(ChunkPart.Guid, ChunkInfo{ .Guid = ChunkPart.Guid, .WindowSize = 1 << 20 });
             }
 
-            auto JsonInstallTags = JsonFileManifest.FindMember("InstallTags");
-            if (JsonInstallTags != JsonFileManifest.MemberEnd() && JsonInstallTags->value.IsArray()) {
+            auto JsonInstallTags = FileMembers.Find("InstallTags");
+            if (JsonInstallTags != FileMembers.GetEnd() && JsonInstallTags->value.IsArray()) {
                 FileManifest.InstallTags.reserve(JsonInstallTags->value.GetArray().Size());
                 for (auto& JsonInstallTag : JsonInstallTags->value.GetArray()) {
                     if (!JsonInstallTag.IsString()) {
@@ -292,28 +288,28 @@ namespace EGL3::Web::Epic::BPS {
                 }
             }
 
-            auto JsonIsUnixExecutable = JsonFileManifest.FindMember("bIsUnixExecutable");
-            if (JsonIsUnixExecutable != JsonFileManifest.MemberEnd() && JsonIsUnixExecutable->value.IsBool() && JsonIsUnixExecutable->value.GetBool()) {
+            auto JsonIsUnixExecutable = FileMembers.Find("bIsUnixExecutable");
+            if (JsonIsUnixExecutable != FileMembers.GetEnd() && JsonIsUnixExecutable->value.IsBool() && JsonIsUnixExecutable->value.GetBool()) {
                 FileManifest.FileMetaFlags = (FileMetaFlags)((uint8_t)FileManifest.FileMetaFlags | (uint8_t)FileMetaFlags::UnixExecutable);
             }
 
-            auto JsonIsReadOnly = JsonFileManifest.FindMember("bIsReadOnly");
-            if (JsonIsReadOnly != JsonFileManifest.MemberEnd() && JsonIsReadOnly->value.IsBool() && JsonIsReadOnly->value.GetBool()) {
+            auto JsonIsReadOnly = FileMembers.Find("bIsReadOnly");
+            if (JsonIsReadOnly != FileMembers.GetEnd() && JsonIsReadOnly->value.IsBool() && JsonIsReadOnly->value.GetBool()) {
                 FileManifest.FileMetaFlags = (FileMetaFlags)((uint8_t)FileManifest.FileMetaFlags | (uint8_t)FileMetaFlags::ReadOnly);
             }
 
-            auto JsonIsCompressed = JsonFileManifest.FindMember("bIsCompressed");
-            if (JsonIsCompressed != JsonFileManifest.MemberEnd() && JsonIsCompressed->value.IsBool() && JsonIsCompressed->value.GetBool()) {
+            auto JsonIsCompressed = FileMembers.Find("bIsCompressed");
+            if (JsonIsCompressed != FileMembers.GetEnd() && JsonIsCompressed->value.IsBool() && JsonIsCompressed->value.GetBool()) {
                 FileManifest.FileMetaFlags = (FileMetaFlags)((uint8_t)FileManifest.FileMetaFlags | (uint8_t)FileMetaFlags::Compressed);
             }
 
-            TryGetString(JsonFileManifest, "SymlinkTarget", FileManifest.SymlinkTarget);
+            TryGetString(FileMembers, "SymlinkTarget", FileManifest.SymlinkTarget);
         }
         FileManifestList.OnPostLoad();
 
         bool HasChunkHashList = false;
-        auto JsonChunkHashList = Json.FindMember("ChunkHashList");
-        if (JsonChunkHashList == Json.MemberEnd() || !JsonChunkHashList->value.IsObject()) {
+        auto JsonChunkHashList = Members.Find("ChunkHashList");
+        if (JsonChunkHashList == Members.GetEnd() || !JsonChunkHashList->value.IsObject()) {
             SetError(ErrorType::BadJson);
             return;
         }
@@ -334,8 +330,8 @@ namespace EGL3::Web::Epic::BPS {
             }
         }
 
-        auto JsonChunkShaList = Json.FindMember("ChunkShaList");
-        if (JsonChunkShaList != Json.MemberEnd()) {
+        auto JsonChunkShaList = Members.Find("ChunkShaList");
+        if (JsonChunkShaList != Members.GetEnd()) {
             if (!JsonChunkShaList->value.IsObject()) {
                 SetError(ErrorType::BadJson);
                 return;
@@ -357,8 +353,8 @@ namespace EGL3::Web::Epic::BPS {
             }
         }
 
-        auto JsonPrereqIdsList = Json.FindMember("PrereqIds");
-        if (JsonPrereqIdsList != Json.MemberEnd()) {
+        auto JsonPrereqIdsList = Members.Find("PrereqIds");
+        if (JsonPrereqIdsList != Members.GetEnd()) {
             if (!JsonPrereqIdsList->value.IsArray()) {
                 SetError(ErrorType::BadJson);
                 return;
@@ -381,8 +377,8 @@ namespace EGL3::Web::Epic::BPS {
             }
         }
 
-        auto JsonDataGroupList = Json.FindMember("DataGroupList");
-        if (JsonDataGroupList != Json.MemberEnd()) {
+        auto JsonDataGroupList = Members.Find("DataGroupList");
+        if (JsonDataGroupList != Members.GetEnd()) {
             if (!JsonDataGroupList->value.IsObject()) {
                 SetError(ErrorType::BadJson);
                 return;
@@ -411,8 +407,8 @@ namespace EGL3::Web::Epic::BPS {
         }
 
         bool HasChunkFilesizeList = false;
-        auto JsonChunkFilesizeList = Json.FindMember("ChunkFilesizeList");
-        if (JsonChunkFilesizeList != Json.MemberEnd()) {
+        auto JsonChunkFilesizeList = Members.Find("ChunkFilesizeList");
+        if (JsonChunkFilesizeList != Members.GetEnd()) {
             if (!JsonChunkFilesizeList->value.IsObject()) {
                 SetError(ErrorType::BadJson);
                 return;
@@ -441,12 +437,12 @@ namespace EGL3::Web::Epic::BPS {
             }
         }
 
-        if (!TryGet<bool>(Json, "bIsFileData", ManifestMeta.IsFileData)) {
+        if (!TryGet<bool>(Members, "bIsFileData", ManifestMeta.IsFileData)) {
             ManifestMeta.IsFileData = !HasChunkHashList;
         }
 
-        auto JsonCustomFields = Json.FindMember("CustomFields");
-        if (JsonCustomFields != Json.MemberEnd()) {
+        auto JsonCustomFields = Members.Find("CustomFields");
+        if (JsonCustomFields != Members.GetEnd()) {
             if (!JsonCustomFields->value.IsObject()) {
                 SetError(ErrorType::BadJson);
                 return;
@@ -467,6 +463,31 @@ namespace EGL3::Web::Epic::BPS {
         }
 
         ManifestMeta.BuildId = ManifestMeta.GetBackwardsCompatibleBuildId();
+
+        if (!ArePartsValid()) {
+            SetError(ErrorType::CorruptData);
+        }
+    }
+
+    bool Manifest::ArePartsValid() const
+    {
+        std::vector<std::pair<Utils::Guid, uint32_t>> WindowSizes;
+        WindowSizes.reserve(ChunkDataList.ChunkList.size());
+        for (auto& Chunk : ChunkDataList.ChunkList) {
+            WindowSizes.emplace_back(Chunk.Guid, Chunk.WindowSize);
+        }
+        std::sort(WindowSizes.begin(), WindowSizes.end());
+
+        // Installs copy parts out of their chunk's window, so they have to fit inside of it
+        for (auto& File : FileManifestList.FileList) {
+            for (auto& Part : File.ChunkParts) {
+                auto Itr = std::lower_bound(WindowSizes.begin(), WindowSizes.end(), std::make_pair(Part.Guid, 0u));
+                if (Itr == WindowSizes.end() || Itr->first != Part.Guid || (uint64_t)Part.Offset + Part.Size > Itr->second) {
+                    return false;
+                }
+            }
+        }
+        return true;
     }
 
     void Manifest::SetError(ErrorType NewError)
@@ -476,16 +497,27 @@ namespace EGL3::Web::Epic::BPS {
 
     Stream& operator>>(Stream& Stream, Manifest& Val)
     {
+        if (Stream.tell() >= Stream.size()) {
+            Val.SetError(Manifest::ErrorType::InvalidMagic);
+            return Stream;
+        }
+
         // Check if JSON and parse accordingly
-        // Not the best speed if Stream is a FileStream since rapidjson loves caling JsonWrapperStream's Tell which in turn calls fseek/ftell
         {
             char PeekChar;
             Stream.read(&PeekChar, 1);
             Stream.seek(-1, Stream::Cur);
             if (PeekChar == '{') {
+                // Parse in place from one contiguous buffer, reading through the stream
+                // costs a few virtual calls per character, which adds up quickly with
+                // 100+ MB manifests. The document's strings point into this buffer.
+                size_t JsonSize = Stream.size() - Stream.tell();
+                auto JsonData = std::make_unique<char[]>(JsonSize + 1);
+                Stream.read(JsonData.get(), JsonSize);
+                JsonData[JsonSize] = '\0';
+
                 rapidjson::Document Json;
-                Utils::JsonWrapperStream JsonStream(Stream);
-                Json.ParseStream(JsonStream);
+                Json.ParseInsitu(JsonData.get());
 
                 Val.ReadFromJson(Json);
                 return Stream;
@@ -506,6 +538,13 @@ namespace EGL3::Web::Epic::BPS {
             return Stream;
         }
 
+        // Sizes come straight from the data, check them before anything is allocated from them
+        if (Header.DataSizeCompressed > Stream.size() - std::min(Stream.tell(), Stream.size()) || Header.IsEncrypted() ||
+            (Header.IsCompressed() ? Header.DataSizeUncompressed > Header.DataSizeCompressed * Utils::Compressor<Utils::CompressionMethod::Zlib>::MaxRatio : Header.DataSizeUncompressed != Header.DataSizeCompressed)) {
+            Val.SetError(Manifest::ErrorType::CorruptData);
+            return Stream;
+        }
+
         // Read data
         std::unique_ptr<char[]> ManifestData = std::make_unique<char[]>(Header.DataSizeCompressed);
         Stream.read(ManifestData.get(), Header.DataSizeCompressed);
@@ -540,6 +579,11 @@ namespace EGL3::Web::Epic::BPS {
         DataStream >> Val.FileManifestList;
         DataStream >> Val.CustomFields;
 
+        if (DataStream.HasError() || !Val.ArePartsValid()) {
+            Val.SetError(Manifest::ErrorType::CorruptData);
+            return Stream;
+        }
+
         Val.SetError(Manifest::ErrorType::Success);
         return Stream;
     }
@@ -28,6 +28,7 @@ namespace EGL3::Web::Epic::BPS {
             TooOld,
             BadCompression,
             BadHash,
+            CorruptData,
         };
 
         bool HasError() const;
@@ -41,6 +42,9 @@ namespace EGL3::Web::Epic::BPS {
     private:
         void ReadFromJson(const rapidjson::Document& Json);
 
+        // Every chunk part points to a chunk in the list and fits inside its window
+        bool ArePartsValid() const;
+
         void SetError(ErrorType NewError);
 
         ErrorType Error;
@@ -1,20 +1,47 @@
 #pragma once
 
 #include "../../../utils/streams/BufferStream.h"
-#include "../../../utils/Log.h"
 #include "../../../utils/Guid.h"
 
+#include <filesystem>
+#include <limits>
 #include <memory>
 
 namespace EGL3::Web::Epic::BPS {
     class UEStream : public Utils::Streams::BufferStream {
     public:
         UEStream(char* Start, size_t Size) :
-            Utils::Streams::BufferStream(Start, Size)
+            Utils::Streams::BufferStream(Start, Size),
+            Error(false)
         {
 
         }
 
+        // Set once anything tried to read past the end, or a length or count was larger than what's left
+        bool HasError() const {
+            return Error;
+        }
+
+        // Every element takes at least MinElementSize bytes, so a valid count can't be more than what's left
+        bool IsCountValid(int64_t Count, size_t MinElementSize = 1) {
+            if (Count < 0 || GetRemaining() / MinElementSize < (uint64_t)Count) {
+                Error = true;
+                return false;
+            }
+            return true;
+        }
+
+        // Short reads are zero filled, the data is untrusted and partially initialized values are worse
+        Utils::Streams::Stream& read(char* Buf, size_t BufCount) override {
+            auto Remaining = GetRemaining();
+            if (BufCount > Remaining) {
+                Error = true;
+                memset(Buf + Remaining, 0, BufCount - Remaining);
+                BufCount = Remaining;
+            }
+            return Utils::Streams::BufferStream::read(Buf, BufCount);
+        }
+
         using Utils::Streams::BufferStream::operator<<;
         using Utils::Streams::BufferStream::operator>>;
 
@@ -47,17 +74,29 @@ namespace EGL3::Web::Epic::BPS {
             if (SaveNum < 0) // LoadUCS2Char
             {
                 // If SaveNum cannot be negated due to integer overflow, Ar is corrupted.
-                EGL3_VERIFY(SaveNum != std::numeric_limits<int>::min(), "Tried to read FString with an invalid length");
-
+                if (SaveNum == std::numeric_limits<int>::min() || !IsCountValid(-(int64_t)SaveNum, sizeof(char16_t))) {
+                    Error = true;
+                    Val.clear();
+                    return *this;
+                }
                 SaveNum = -SaveNum;
 
                 std::wstring StringData(SaveNum, '\0');
                 read((char*)StringData.data(), SaveNum * sizeof(char16_t));
+                // Drop the null terminator
+                StringData.resize(SaveNum - 1);
                 Val = std::filesystem::path(StringData).string();
             }
             else {
+                if (!IsCountValid(SaveNum)) {
+                    Val.clear();
+                    return *this;
+                }
+
                 Val.resize(SaveNum - 1);
-                read(Val.data(), SaveNum);
+                read(Val.data(), SaveNum - 1);
+                // Skip the null terminator
+                seek(1, Cur);
             }
 
             return *this;
@@ -67,11 +106,21 @@ namespace EGL3::Web::Epic::BPS {
         UEStream& operator>>(std::vector<T>& Val) {
             int SerializeNum;
             *this >> SerializeNum;
+            if (!IsCountValid(SerializeNum)) {
+                return *this;
+            }
             Val.reserve(SerializeNum);
             for (int i = 0; i < SerializeNum; ++i) {
                 *this >> Val.emplace_back();
             }
             return *this;
         }
+
+    private:
+        size_t GetRemaining() const {
+            return tell() < size() ? size() - tell() : 0;
+        }
+
+        bool Error;
     };
 }
@@ -33,7 +33,7 @@ namespace EGL3::Web::Epic::Friends {
         Launcher.OnDisconnected.Set([]() {
             EGL3_LOG(LogLevel::Info, "Launcher disconnected");
         });
-        Launcher.OnMessage.Set([this](const std::string& SubscriptionId, const Stomp::Frame& Frame) {
+        Launcher.OnMessage.Set([this](std::string_view SubscriptionId, const Stomp::FrameView& Frame) {
             ReadStompMessage<false>(Frame);
         });
 
@@ -46,7 +46,7 @@ namespace EGL3::Web::Epic::Friends {
         EOS.OnDisconnected.Set([]() {
             EGL3_LOG(LogLevel::Info, "EOS disconnected");
         });
-        EOS.OnMessage.Set([this](const std::string& SubscriptionId, const Stomp::Frame& Frame) {
+        EOS.OnMessage.Set([this](std::string_view SubscriptionId, const Stomp::FrameView& Frame) {
             ReadStompMessage<true>(Frame);
         });
 
@@ -186,14 +186,13 @@ namespace EGL3::Web::Epic::Friends {
     }
 
     template<bool IsEOS>
-    void FriendsClient::ReadStompMessage(const Stomp::Frame& Frame)
+    void FriendsClient::ReadStompMessage(const Stomp::FrameView& Frame)
     {
-        auto& Headers = Frame.GetHeaders();
-        auto ContentTypeItr = Headers.find("Content-Type");
-        if (ContentTypeItr == Headers.end()) {
+        auto ContentType = Frame.GetHeader("Content-Type");
+        if (!ContentType) {
             return;
         }
-        if (ContentTypeItr->second != "application/json") {
+        if (*ContentType != "application/json") {
             return;
         }
 
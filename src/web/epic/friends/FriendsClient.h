@@ -47,7 +47,7 @@ namespace EGL3::Web::Epic::Friends {
         void SendPresenceFortnite();
 
         template<bool IsEOS>
-        void ReadStompMessage(const Stomp::Frame& Frame);
+        void ReadStompMessage(const Stomp::FrameView& Frame);
 
         template<FriendEventType Event>
         void ReadFriendEventPayload(const Stomp::Messages::Message& Message);
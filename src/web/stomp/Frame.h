@@ -13,8 +13,6 @@ namespace EGL3::Web::Stomp {
     public:
         Frame(CommandType Command, Headers&& Headers, std::string&& Body);
 
-        Frame(std::string_view Data);
-
         std::string Encode() const;
 
         CommandType GetCommand() const noexcept;
@@ -24,8 +22,6 @@ namespace EGL3::Web::Stomp {
         const std::string& GetBody() const noexcept;
 
     private:
-        void Decode(std::string_view Data);
-
         CommandType Command;
         Headers Headers;
         std::string Body;
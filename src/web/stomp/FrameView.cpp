@@ -0,0 +1,150 @@
+#include "FrameView.h"
+
+#include "../../utils/StringCompare.h"
+
+#include <charconv>
+
+namespace EGL3::Web::Stomp {
+    FrameView::FrameView(std::string_view Data) :
+        Command(CommandType::Heartbeat)
+    {
+        Decode(Data);
+    }
+
+    CommandType FrameView::GetCommand() const noexcept
+    {
+        return Command;
+    }
+
+    const HeaderViews& FrameView::GetHeaders() const noexcept
+    {
+        return Headers;
+    }
+
+    std::optional<std::string_view> FrameView::GetHeader(std::string_view Name) const noexcept
+    {
+        for (auto& Header : Headers) {
+            if (Utils::CompareStringsInsensitive(Header.first, Name) == 0) {
+                return Header.second;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::string_view FrameView::GetBody() const noexcept
+    {
+        return Body;
+    }
+
+    static void SkipNewlines(std::string_view& Data)
+    {
+        Data.remove_prefix(std::min(Data.find_first_not_of("\r\n"), Data.size()));
+    }
+
+    char FrameView::ReadValue(std::string_view& Data, std::string_view& Value, std::string_view Delimiters, bool AllowEscaping)
+    {
+        char Retval = '\0';
+        bool HasEscapes = false;
+        size_t Idx = 0;
+        for (; Idx < Data.size(); ++Idx) {
+            if (AllowEscaping && Data[Idx] == '\\') {
+                HasEscapes = true;
+                ++Idx;
+                continue;
+            }
+            if (Delimiters.find(Data[Idx]) != std::string_view::npos) {
+                Retval = Data[Idx];
+                break;
+            }
+        }
+        Idx = std::min(Idx, Data.size());
+
+        Value = Data.substr(0, Idx);
+        Data.remove_prefix(Retval != '\0' ? Idx + 1 : Idx);
+
+        // An escaped character is taken as is, the same way Frame::Encode escapes them
+        if (HasEscapes) {
+            auto& Unescaped = UnescapedValues.emplace_back();
+            Unescaped.reserve(Value.size());
+            for (size_t CharIdx = 0; CharIdx < Value.size(); ++CharIdx) {
+                if (Value[CharIdx] == '\\' && ++CharIdx == Value.size()) {
+                    break;
+                }
+                Unescaped += Value[CharIdx];
+            }
+            Value = Unescaped;
+        }
+
+        // The stomp protocol also allows \r\n in addition to \n as line delimiter -- simply trim the \r off the end if present
+        // (Unhandled edge case: In case the buffer contains an escaped CR followed by a terminating newline, the CR will be stripped off in any case)
+        if (Retval == '\n' && !Value.empty() && Value.back() == '\r') {
+            Value.remove_suffix(1);
+        }
+
+        return Retval;
+    }
+
+    void FrameView::Decode(std::string_view Data)
+    {
+        if (!Data.empty() && Data.back() == '\0') {
+            Data.remove_suffix(1);
+        }
+
+        SkipNewlines(Data);
+
+        if (Data.empty()) {
+            Command = CommandType::Heartbeat;
+            return;
+        }
+
+        std::string_view CommandString;
+        ReadValue(Data, CommandString);
+        Command = StringToCommandType(CommandString);
+
+        if (Data.empty()) {
+            // log warning
+            return;
+        }
+
+        Headers.reserve(8);
+        while (!Data.empty()) {
+            std::string_view HeaderName;
+            auto Delimiter = ReadValue(Data, HeaderName, "\n:");
+
+            if (Delimiter == ':') {
+                std::string_view HeaderValue;
+                ReadValue(Data, HeaderValue);
+                Headers.emplace_back(HeaderName, HeaderValue);
+            }
+            else if (HeaderName.empty()) {
+                // Empty line marks the end of headers
+                break;
+            }
+            else {
+                // log warning
+                Headers.emplace_back(HeaderName, std::string_view());
+            }
+        }
+
+        if (auto ContentLengthHeader = GetHeader("content-length")) {
+            size_t ContentLength = Data.size();
+            auto Result = std::from_chars(ContentLengthHeader->data(), ContentLengthHeader->data() + ContentLengthHeader->size(), ContentLength);
+            if (Result.ec != std::errc() || ContentLength > Data.size()) {
+                ContentLength = Data.size();
+                // log warning
+            }
+            Body = Data.substr(0, ContentLength);
+            Data.remove_prefix(ContentLength);
+        }
+        else {
+            Body = Data;
+            Data = {};
+        }
+
+        SkipNewlines(Data);
+
+        if (!Data.empty()) {
+            // log warning
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "CommandType.h"
+
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace EGL3::Web::Stomp {
+    using HeaderViews = std::vector<std::pair<std::string_view, std::string_view>>;
+
+    // A received frame that references the data it was decoded from instead of copying it.
+    // The data must outlive the frame. Only headers that contain escape sequences get copied.
+    class FrameView {
+    public:
+        FrameView(std::string_view Data);
+
+        FrameView(const FrameView&) = delete;
+        FrameView& operator=(const FrameView&) = delete;
+
+        CommandType GetCommand() const noexcept;
+
+        const HeaderViews& GetHeaders() const noexcept;
+
+        // Header names are case insensitive, and only the first of any repeated header is used
+        std::optional<std::string_view> GetHeader(std::string_view Name) const noexcept;
+
+        std::string_view GetBody() const noexcept;
+
+    private:
+        void Decode(std::string_view Data);
+
+        char ReadValue(std::string_view& Data, std::string_view& Value, std::string_view Delimiters = "\n", bool AllowEscaping = true);
+
+        CommandType Command;
+        HeaderViews Headers;
+        std::string_view Body;
+        std::deque<std::string> UnescapedValues;
+    };
+}
\ No newline at end of file
@@ -54,7 +54,7 @@ namespace EGL3::Web::Stomp {
         {
         case ix::WebSocketMessageType::Message:
             //EGL3_LOGF(LogLevel::Debug, "[STOMP] RECV - {}", Message->str);
-            RecievedFrame(Frame(Message->str));
+            RecievedFrame(FrameView(Message->str));
             break;
         case ix::WebSocketMessageType::Open:
             SendConnect();
@@ -73,15 +73,14 @@ namespace EGL3::Web::Stomp {
         }
     }
 
-    void StompClient::RecievedFrame(const Frame& Frame)
+    void StompClient::RecievedFrame(const FrameView& Frame)
     {
-        auto& Headers = Frame.GetHeaders();
         switch (Frame.GetCommand()) {
         case CommandType::Connected:
         {
-            auto HeartbeatItr = Headers.find("heart-beat");
-            if (HeartbeatItr != Headers.end()) {
-                std::string_view Intervals = HeartbeatItr->second;
+            auto HeartbeatHeader = Frame.GetHeader("heart-beat");
+            if (HeartbeatHeader) {
+                std::string_view Intervals = *HeartbeatHeader;
                 auto CommaIdx = Intervals.find(',');
                 if (CommaIdx != std::string_view::npos) {
                     std::chrono::milliseconds::rep ServerPing = 0, ServerPong = 0;
@@ -99,9 +98,9 @@ namespace EGL3::Web::Stomp {
                 PongInterval = std::chrono::milliseconds(0);
             }
 
-            auto VersionItr = Headers.find("version");
-            if (VersionItr != Headers.end()) {
-                // printf("version %s\n", VersionItr->second.c_str());
+            auto VersionHeader = Frame.GetHeader("version");
+            if (VersionHeader) {
+                // printf("version %.*s\n", (int)VersionHeader->size(), VersionHeader->data());
             }
 
             OnConnected();
@@ -110,9 +109,9 @@ namespace EGL3::Web::Stomp {
         }
         case CommandType::Message:
         {
-            auto SubscriptionItr = Headers.find("subscription");
-            if (SubscriptionItr != Headers.end()) {
-                OnMessage(SubscriptionItr->second, Frame);
+            auto SubscriptionHeader = Frame.GetHeader("subscription");
+            if (SubscriptionHeader) {
+                OnMessage(*SubscriptionHeader, Frame);
             }
             break;
         }
@@ -2,6 +2,7 @@
 
 #include "../../utils/Callback.h"
 #include "Frame.h"
+#include "FrameView.h"
 
 #include <future>
 #include <ixwebsocket/IXWebSocket.h>
@@ -21,12 +22,12 @@ namespace EGL3::Web::Stomp {
 
         Utils::Callback<void()> OnConnected;
         Utils::Callback<void()> OnDisconnected;
-        Utils::Callback<void(const std::string& SubscriptionId, const Frame& Frame)> OnMessage;
+        Utils::Callback<void(std::string_view SubscriptionId, const FrameView& Frame)> OnMessage;
 
     private:
         void ReceivedMessage(const ix::WebSocketMessagePtr& Message);
 
-        void RecievedFrame(const Frame& Frame);
+        void RecievedFrame(const FrameView& Frame);
 
         void RunHeartbeatTask();
 
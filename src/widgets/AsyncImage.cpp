@@ -30,8 +30,8 @@ namespace EGL3::Widgets {
 
     void AsyncImage::ConstructDispatcher() {
         ImageDispatcher.connect([this]() {
-            if (ImageTask.valid()) {
-                this->set(ImageTask.get());
+            if (ImageTask.IsValid() && ImageTask.IsReady()) {
+                this->set(ImageTask.Get());
             }
         });
 
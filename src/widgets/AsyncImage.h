@@ -28,7 +28,7 @@ namespace EGL3::Widgets {
         };
         std::unique_ptr<ImageInfo> ImageData;
 
-        std::future<Glib::RefPtr<Gdk::Pixbuf>> ImageTask;
+        Utils::Future<Glib::RefPtr<Gdk::Pixbuf>> ImageTask;
         Glib::Dispatcher ImageDispatcher;
     };
 }
@@ -3,6 +3,40 @@
 #include "../modules/Friends/KairosMenu.h"
 
 namespace EGL3::Widgets {
+    // Sets all of a row's columns in one call, a sorted store repositions the row on every set call,
+    // so this moves an updated row once instead of once per column
+    class RowValues {
+    public:
+        ~RowValues()
+        {
+            for (auto& Value : Values) {
+                g_value_unset(&Value);
+            }
+        }
+
+        template<class T>
+        void Add(const Gtk::TreeModelColumn<T>& Column, const std::type_identity_t<T>& Value)
+        {
+            typename Gtk::TreeModelColumn<T>::ValueType Typed;
+            Typed.init(Column.type());
+            Typed.set(Value);
+
+            auto& Raw = Values.emplace_back(GValue G_VALUE_INIT);
+            g_value_init(&Raw, Column.type());
+            g_value_copy(Typed.gobj(), &Raw);
+            Indices.emplace_back(Column.index());
+        }
+
+        void Apply(const Glib::RefPtr<Gtk::ListStore>& Store, const Gtk::TreeRow& Row)
+        {
+            gtk_list_store_set_valuesv(Store->gobj(), const_cast<GtkTreeIter*>(Row.gobj()), Indices.data(), Values.data(), (int)Values.size());
+        }
+
+    private:
+        std::vector<int> Indices;
+        std::vector<GValue> Values;
+    };
+
     FriendList::FriendList(Gtk::TreeView& TreeView, Modules::ImageCacheModule& ImageCache) :
         ImageCache(ImageCache),
         TreeView(TreeView),
@@ -80,10 +114,17 @@ namespace EGL3::Widgets {
         });
 
         SetupColumns();
+
+        PendingRowsDispatcher.connect([this]() { UpdatePendingRows(); });
     }
 
     FriendList::~FriendList()
     {
+        {
+            std::lock_guard Guard(PendingRowsMtx);
+            PendingRows.clear();
+        }
+
         ListStore->clear();
 
         TreeView.remove_all_columns();
@@ -102,21 +143,41 @@ namespace EGL3::Widgets {
         auto& Row = *Itr;
         Row[Columns.Data] = &Friend;
         Row[Columns.UpdateSlot] = Friend.Get().OnUpdate.connect(
-            [this, ListStoreRef = Glib::WeakRef<Gtk::ListStore>(ListStore), Ref = std::move(Ref)]() {
-                Glib::signal_idle().connect_once(
-                    [this, ListStoreRef, Ref]() {
-                        auto ListStore = ListStoreRef.get();
-                        if (Ref.is_valid() && ListStoreRef && ListStore) {
-                            UpdateFriendRow(*ListStore->get_iter(Ref.get_path()));
-                        }
-                    },
-                    Glib::PRIORITY_HIGH_IDLE
-                );
+            [this, &Friend, Ref = std::move(Ref)]() {
+                QueueRowUpdate(&Friend, Ref);
             }
         );
         UpdateFriendRow(Row);
     }
 
+    void FriendList::QueueRowUpdate(Storage::Models::Friend* Friend, const Gtk::TreeRowReference& Ref)
+    {
+        std::lock_guard Guard(PendingRowsMtx);
+
+        bool WasEmpty = PendingRows.empty();
+        PendingRows.insert_or_assign(Friend, Ref);
+        // Otherwise the drain is already queued and will pick this up too
+        if (WasEmpty) {
+            PendingRowsDispatcher.emit();
+        }
+    }
+
+    void FriendList::UpdatePendingRows()
+    {
+        decltype(PendingRows) Rows;
+        {
+            std::lock_guard Guard(PendingRowsMtx);
+            Rows.swap(PendingRows);
+        }
+
+        // Each updated row is moved into place on its own, the rest of the list is left alone
+        for (auto& Row : Rows) {
+            if (Row.second.is_valid()) {
+                UpdateFriendRow(*ListStore->get_iter(Row.second.get_path()));
+            }
+        }
+    }
+
     void FriendList::Refilter()
     {
         ListFilter->refilter();
@@ -185,54 +246,58 @@ namespace EGL3::Widgets {
         auto& FriendContainer = *(EGL3::Storage::Models::Friend*)Row[Columns.Data];
         auto& Friend = FriendContainer.Get();
 
-        Row[Columns.DisplayNameMarkup] = std::format("<b>{}</b> <small><i>{}</i></small>", (std::string)Glib::Markup::escape_text(Friend.GetDisplayName()), (std::string)Glib::Markup::escape_text(Friend.GetSecondaryName()));
+        RowValues Values;
+
+        Values.Add(Columns.DisplayNameMarkup, std::format("<b>{}</b> <small><i>{}</i></small>", (std::string)Glib::Markup::escape_text(Friend.GetDisplayName()), (std::string)Glib::Markup::escape_text(Friend.GetSecondaryName())));
 
-        Row[Columns.KairosAvatar] = Modules::Friends::KairosMenuModule::GetRandomKairosAvatar();
-        Row[Columns.KairosBackground] = Modules::Friends::KairosMenuModule::GetRandomKairosBackground();
+        Values.Add(Columns.KairosAvatar, Modules::Friends::KairosMenuModule::GetRandomKairosAvatar());
+        Values.Add(Columns.KairosBackground, Modules::Friends::KairosMenuModule::GetRandomKairosBackground());
 
         if (FriendContainer.GetType() == Storage::Models::FriendType::NORMAL || FriendContainer.GetType() == Storage::Models::FriendType::CURRENT) {
             auto& FriendData = FriendContainer.Get<Storage::Models::FriendReal>();
 
-            Row[Columns.Status] = FriendData.GetStatus();
+            Values.Add(Columns.Status, FriendData.GetStatus());
 
             if (FriendData.GetStatus() != Web::Xmpp::Status::Offline) {
-                Row[Columns.Product] = FriendData.GetProductId();
-                Row[Columns.Platform] = FriendData.GetPlatformId();
+                Values.Add(Columns.Product, FriendData.GetProductId());
+                Values.Add(Columns.Platform, FriendData.GetPlatformId());
 
                 if (FriendData.GetStatusText().empty()) {
-                    Row[Columns.Description] = Web::Xmpp::StatusToHumanString(FriendData.GetStatus());
+                    Values.Add(Columns.Description, Web::Xmpp::StatusToHumanString(FriendData.GetStatus()));
                 }
                 else {
-                    Row[Columns.Description] = FriendData.GetStatusText();
+                    Values.Add(Columns.Description, FriendData.GetStatusText());
                     // TODO: add this as a tooltip too (somehow...)
                 }
             }
             else {
-                Row[Columns.Product] = "";
-                Row[Columns.Platform] = "";
+                Values.Add(Columns.Product, "");
+                Values.Add(Columns.Platform, "");
 
-                Row[Columns.Description] = Web::Xmpp::StatusToHumanString(Web::Xmpp::Status::Offline);
+                Values.Add(Columns.Description, Web::Xmpp::StatusToHumanString(Web::Xmpp::Status::Offline));
             }
         }
         else {
-            Row[Columns.Status] = Web::Xmpp::Status::Offline;
+            Values.Add(Columns.Status, Web::Xmpp::Status::Offline);
 
             switch (FriendContainer.GetType())
             {
             case Storage::Models::FriendType::INBOUND:
-                Row[Columns.Description] = "Incoming Friend Request";
+                Values.Add(Columns.Description, "Incoming Friend Request");
                 break;
             case Storage::Models::FriendType::OUTBOUND:
-                Row[Columns.Description] = "Outgoing Friend Request";
+                Values.Add(Columns.Description, "Outgoing Friend Request");
                 break;
             case Storage::Models::FriendType::BLOCKED:
-                Row[Columns.Description] = "Blocked";
+                Values.Add(Columns.Description, "Blocked");
                 break;
             default:
-                Row[Columns.Description] = "Unknown User";
+                Values.Add(Columns.Description, "Unknown User");
                 break;
             }
         }
+
+        Values.Apply(ListStore, Row);
     }
 
     FriendList::CellType FriendList::GetCellType(const Gtk::CellRenderer* Renderer) const noexcept
@@ -6,6 +6,8 @@
 #include "CellRendererCenterText.h"
 
 #include <gtkmm.h>
+#include <mutex>
+#include <unordered_map>
 
 namespace EGL3::Widgets {
     class FriendList {
@@ -79,6 +81,10 @@ namespace EGL3::Widgets {
 
         void UpdateFriendRow(const Gtk::TreeRow& Row);
 
+        void QueueRowUpdate(Storage::Models::Friend* Friend, const Gtk::TreeRowReference& Ref);
+
+        void UpdatePendingRows();
+
         CellType GetCellType(const Gtk::CellRenderer* Renderer) const noexcept;
 
         Modules::ImageCacheModule& ImageCache;
@@ -95,6 +101,11 @@ namespace EGL3::Widgets {
         Utils::SlotHolder SlotTooltip;
         Utils::SlotHolder SlotClick;
 
+        // Updates come from the network thread, the dispatcher is emitted once per batch and drains it on the gui thread
+        std::mutex PendingRowsMtx;
+        std::unordered_map<Storage::Models::Friend*, Gtk::TreeRowReference> PendingRows;
+        Glib::Dispatcher PendingRowsDispatcher;
+
         struct ModelColumns : public Gtk::TreeModel::ColumnRecord
         {
             ModelColumns()
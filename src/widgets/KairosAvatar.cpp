@@ -15,14 +15,14 @@ namespace EGL3::Widgets {
         set_name("kairos-avatar");
 
         Dispatcher.connect([this]() {
-            if (AvatarTask.valid() && AvatarTask.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
-                AvatarPixbuf = AvatarTask.get();
+            if (AvatarTask.IsValid() && AvatarTask.IsReady()) {
+                AvatarPixbuf = AvatarTask.Get();
                 if (get_mapped()) {
                     queue_draw();
                 }
             }
-            if (BackgroundTask.valid() && BackgroundTask.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
-                BackgroundPixbuf = BackgroundTask.get();
+            if (BackgroundTask.IsValid() && BackgroundTask.IsReady()) {
+                BackgroundPixbuf = BackgroundTask.Get();
                 if (get_mapped()) {
                     queue_draw();
                 }
@@ -28,11 +28,11 @@ namespace EGL3::Widgets {
 
         std::string Avatar;
         Glib::RefPtr<Gdk::Pixbuf> AvatarPixbuf;
-        std::future<Glib::RefPtr<Gdk::Pixbuf>> AvatarTask;
+        Utils::Future<Glib::RefPtr<Gdk::Pixbuf>> AvatarTask;
 
         std::string Background;
         Glib::RefPtr<Gdk::Pixbuf> BackgroundPixbuf;
-        std::future<Glib::RefPtr<Gdk::Pixbuf>> BackgroundTask;
+        Utils::Future<Glib::RefPtr<Gdk::Pixbuf>> BackgroundTask;
 
         Glib::Dispatcher Dispatcher;
     };